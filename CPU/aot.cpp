@@ -0,0 +1,90 @@
+#ifdef MEGABOY_AOT
+
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include <dlfcn.h>
+#include "aot.h"
+#include "cpu.h"
+#include "native_block.h"
+#include "../cartridge/CartridgeHeader.h"
+
+// Generated code accesses the registers through AOTRegisters
+static_assert(sizeof(AOTRegisters) == sizeof(CPU::GeneralRegisters));
+static_assert(offsetof(AOTRegisters, BC) == offsetof(CPU::GeneralRegisters, BC));
+static_assert(offsetof(AOTRegisters, DE) == offsetof(CPU::GeneralRegisters, DE));
+static_assert(offsetof(AOTRegisters, HL) == offsetof(CPU::GeneralRegisters, HL));
+static_assert(offsetof(AOTRegisters, AF) == offsetof(CPU::GeneralRegisters, AF));
+static_assert(offsetof(AOTRegisters, SP) == offsetof(CPU::GeneralRegisters, SP));
+static_assert(offsetof(AOTRegisters, PC) == offsetof(CPU::GeneralRegisters, PC));
+static_assert(std::is_same_v<decltype(AOTBlock::code), NativeBlock>);
+
+AOTLibrary::~AOTLibrary()
+{
+    Unload();
+}
+
+bool AOTLibrary::Load(const std::string &path, const CartridgeHeader &header)
+{
+    Unload();
+
+    void *library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr)
+    {
+        std::cout << "Could not load AOT library " << path << ": " << dlerror() << std::endl;
+        return false;
+    }
+
+    auto *module = static_cast<const AOTModule *>(dlsym(library, AOTModuleSymbol));
+    if (module == nullptr || module->abi_version != AOTAbiVersion)
+    {
+        std::cout << "AOT library " << path << " was built by another version of MegaBoy" << std::endl;
+        dlclose(library);
+        return false;
+    }
+
+    if (module->rom_id != AOTROMId(header.header_checksum, header.global_checksum))
+    {
+        std::cout << "AOT library " << path << " was built from another ROM" << std::endl;
+        dlclose(library);
+        return false;
+    }
+
+    *module->interpret = &InterpretInstruction;
+
+    handle = library;
+    for (uint32_t i = 0; i < module->block_count; i++)
+    {
+        const AOTBlock &block = module->blocks[i];
+        blocks[(static_cast<uint32_t>(block.bank) << 16) | block.pc] = &block;
+    }
+
+    return true;
+}
+
+void AOTLibrary::Unload()
+{
+    if (handle != nullptr)
+    {
+        blocks.clear();
+        dlclose(handle);
+        handle = nullptr;
+    }
+    attached_blocks = 0;
+}
+
+bool AOTLibrary::Attach(DecodedBlock &block, uint16_t bank, uint16_t pc)
+{
+    auto it = blocks.find((static_cast<uint32_t>(bank) << 16) | pc);
+    if (it == blocks.end())
+    {
+        return false;
+    }
+
+    block.native_code = reinterpret_cast<void *>(it->second->code);
+    block.native_cycles = it->second->cycles;
+    attached_blocks++;
+    return true;
+}
+
+#endif // MEGABOY_AOT
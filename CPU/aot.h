@@ -0,0 +1,58 @@
+#pragma once
+
+#ifdef MEGABOY_AOT
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "aot_abi.h"
+#include "block_cache.h"
+
+struct CartridgeHeader;
+
+/// A shared object with the code of a cartridge recompiled ahead of time by the megaboy-aot tool (see aot/StaticRecompiler.h).
+///
+/// Blocks from the library are attached to the BlockCache as their native code the first time they are entered, and run
+/// by `CPU::run_native_code` like JIT compiled blocks. Code the recompiler didn't reach, and code in RAM, is left to the
+/// JIT and the interpreter.
+class AOTLibrary
+{
+public:
+    AOTLibrary() = default;
+    ~AOTLibrary();
+
+    AOTLibrary(const AOTLibrary &) = delete;
+    AOTLibrary &operator=(const AOTLibrary &) = delete;
+
+    /// Load a library built for the cartridge with the given header, replacing any library loaded before.
+    /// Native code attached from a previous library is left in the BlockCache, so reset the CPU afterwards.
+    /// \returns false if the library could not be opened or was built for another cartridge or ABI version
+    bool Load(const std::string &path, const CartridgeHeader &header);
+    void Unload();
+
+    [[nodiscard]] bool IsLoaded() const
+    {
+        return handle != nullptr;
+    }
+
+    /// Set the native code of a block from the library, if it has a block starting at `pc` in ROM bank `bank`.
+    /// \returns whether the block was found
+    bool Attach(DecodedBlock &block, uint16_t bank, uint16_t pc);
+
+    /// Number of blocks in the loaded library
+    [[nodiscard]] size_t BlockCount() const
+    {
+        return blocks.size();
+    }
+
+    /// Number of blocks attached to the BlockCache since the library was loaded
+    uint64_t attached_blocks = 0;
+
+private:
+    void *handle = nullptr;
+    /// Blocks of the library keyed by (bank << 16) | pc, like the BlockCache
+    std::unordered_map<uint32_t, const AOTBlock *> blocks;
+};
+
+#endif // MEGABOY_AOT
@@ -0,0 +1,176 @@
+#pragma once
+
+// Interface between the emulator and the shared objects built by the ahead-of-time recompiler (aot/StaticRecompiler.h).
+// The generated C++ only includes this header, so it compiles quickly and without the rest of the emulator.
+
+#include <cstdint>
+
+class CPU;
+
+/// Bumped whenever anything in this header changes. Libraries built for another version are not loaded.
+constexpr uint32_t AOTAbiVersion = 1;
+
+/// Name of the `AOTModule` exported by a library
+constexpr const char *AOTModuleSymbol = "megaboy_aot_module";
+
+/// Same layout as CPU::GeneralRegisters (checked in aot.cpp)
+struct AOTRegisters
+{
+    union
+    {
+        uint16_t BC;
+        struct
+        {
+            uint8_t C, B;
+        };
+    };
+
+    union
+    {
+        uint16_t DE;
+        struct
+        {
+            uint8_t E, D;
+        };
+    };
+
+    union
+    {
+        uint16_t HL;
+        struct
+        {
+            uint8_t L, H;
+        };
+    };
+
+    union
+    {
+        uint16_t AF;
+        struct
+        {
+            uint8_t F, A;
+        };
+    };
+
+    uint8_t R;
+    uint16_t SP;
+    uint16_t PC;
+};
+
+/// Executes one instruction through the interpreter, see `InterpretInstruction` in native_block.h
+using AOTInterpretFunction = uint32_t (*)(CPU *cpu, uint32_t encoded, uint32_t pc);
+
+/// A recompiled block, starting at `pc` in ROM bank `bank` (as returned by `HostMemory::GetCodeBank`)
+struct AOTBlock
+{
+    uint16_t bank;
+    uint16_t pc;
+    /// Cycles of one pass through the block
+    uint16_t cycles;
+    /// Same signature as `NativeBlock`
+    uint32_t (*code)(CPU *cpu, void *regs, uint32_t budget);
+};
+
+/// Everything a library exports, under the name `AOTModuleSymbol`
+struct AOTModule
+{
+    uint32_t abi_version;
+    /// `AOTROMId` of the cartridge the library was built from
+    uint32_t rom_id;
+    uint32_t block_count;
+    const AOTBlock *blocks;
+    /// Set by the loader before any block is run
+    AOTInterpretFunction *interpret;
+};
+
+/// Identifies a cartridge by its header checksum and global checksum (0x014d - 0x014f)
+inline uint32_t AOTROMId(uint8_t header_checksum, uint16_t global_checksum)
+{
+    return (header_checksum << 16) | global_checksum;
+}
+
+// *********************************************************************************
+// Instructions used by the generated code, with the same flag results as the interpreter.
+// The lower nibble of F is kept as is, like CPU::setFlag does.
+// *********************************************************************************
+
+namespace AOTRuntime
+{
+    inline void SetZNHC(AOTRegisters &regs, bool z, bool n, bool h, bool c)
+    {
+        regs.F = (regs.F & 0x0f) | (z << 7) | (n << 6) | (h << 5) | (c << 4);
+    }
+
+    inline bool Carry(const AOTRegisters &regs)
+    {
+        return regs.F & 0x10;
+    }
+
+    inline void Add(AOTRegisters &regs, uint8_t value, bool carry_in)
+    {
+        uint8_t carry = carry_in && Carry(regs);
+        uint16_t result = regs.A + value + carry;
+        bool half_carry = (regs.A & 0xf) + (value & 0xf) + carry > 0xf;
+        regs.A = static_cast<uint8_t>(result);
+        SetZNHC(regs, regs.A == 0, false, half_carry, result > 0xff);
+    }
+
+    /// SUB, SBC and CP (which only sets the flags)
+    inline void Sub(AOTRegisters &regs, uint8_t value, bool carry_in, bool compare)
+    {
+        uint8_t carry = carry_in && Carry(regs);
+        int result = regs.A - value - carry;
+        bool half_carry = (regs.A & 0xf) - (value & 0xf) - carry < 0;
+        SetZNHC(regs, static_cast<uint8_t>(result) == 0, true, half_carry, result < 0);
+        if (!compare)
+        {
+            regs.A = static_cast<uint8_t>(result);
+        }
+    }
+
+    inline void And(AOTRegisters &regs, uint8_t value)
+    {
+        regs.A &= value;
+        SetZNHC(regs, regs.A == 0, false, true, false);
+    }
+
+    inline void Xor(AOTRegisters &regs, uint8_t value)
+    {
+        regs.A ^= value;
+        SetZNHC(regs, regs.A == 0, false, false, false);
+    }
+
+    inline void Or(AOTRegisters &regs, uint8_t value)
+    {
+        regs.A |= value;
+        SetZNHC(regs, regs.A == 0, false, false, false);
+    }
+
+    inline void Inc(AOTRegisters &regs, uint8_t &reg)
+    {
+        reg++;
+        SetZNHC(regs, reg == 0, false, (reg & 0xf) == 0, Carry(regs));
+    }
+
+    inline void Dec(AOTRegisters &regs, uint8_t &reg)
+    {
+        reg--;
+        SetZNHC(regs, reg == 0, true, (reg & 0xf) == 0xf, Carry(regs));
+    }
+
+    inline void Cpl(AOTRegisters &regs)
+    {
+        regs.A = ~regs.A;
+        regs.F |= 0x60;
+    }
+
+    inline void Scf(AOTRegisters &regs)
+    {
+        regs.F = (regs.F & 0x8f) | 0x10;
+    }
+
+    inline void Ccf(AOTRegisters &regs)
+    {
+        regs.F = (regs.F & 0x9f) ^ 0x10;
+    }
+}
@@ -0,0 +1,183 @@
+#include "block_cache.h"
+#include "cpu.h"
+
+/// Number of bytes of each instruction, including the opcode. Invalid opcodes have length 0 and are never cached.
+static constexpr std::array<uint8_t, 256> make_instruction_lengths()
+{
+    std::array<uint8_t, 256> lengths{};
+    lengths.fill(1);
+
+    for (uint8_t opcode : {0x06, 0x0e, 0x16, 0x1e, 0x26, 0x2e, 0x36, 0x3e, // LD r,n
+                           0x18, 0x20, 0x28, 0x30, 0x38,                   // JR
+                           0xc6, 0xce, 0xd6, 0xde, 0xe6, 0xee, 0xf6, 0xfe, // ALU A,n
+                           0xe0, 0xf0, 0xe8, 0xf8, 0xcb})
+    {
+        lengths[opcode] = 2;
+    }
+
+    for (uint8_t opcode : {0x01, 0x11, 0x21, 0x31, 0x08, 0xea, 0xfa, // LD with 16 bit operand
+                           0xc2, 0xc3, 0xca, 0xd2, 0xda,             // JP
+                           0xc4, 0xcc, 0xcd, 0xd4, 0xdc})            // CALL
+    {
+        lengths[opcode] = 3;
+    }
+
+    for (uint8_t opcode : {0xd3, 0xdb, 0xdd, 0xe3, 0xe4, 0xeb, 0xec, 0xed, 0xf4, 0xfc, 0xfd})
+    {
+        lengths[opcode] = 0;
+    }
+
+    return lengths;
+}
+
+static constexpr std::array<uint8_t, 256> instruction_lengths = make_instruction_lengths();
+
+/// Instructions that can change the control flow end a block
+static constexpr std::array<bool, 256> make_block_ends()
+{
+    std::array<bool, 256> ends{};
+
+    for (uint8_t opcode : {0x18, 0x20, 0x28, 0x30, 0x38,                   // JR
+                           0xc2, 0xc3, 0xca, 0xd2, 0xda, 0xe9,             // JP
+                           0xc4, 0xcc, 0xcd, 0xd4, 0xdc,                   // CALL
+                           0xc0, 0xc8, 0xc9, 0xd0, 0xd8, 0xd9,             // RET, RETI
+                           0xc7, 0xcf, 0xd7, 0xdf, 0xe7, 0xef, 0xf7, 0xff, // RST
+                           0x76, 0x10})                                    // HALT, STOP
+    {
+        ends[opcode] = true;
+    }
+
+    return ends;
+}
+
+static constexpr std::array<bool, 256> block_ends = make_block_ends();
+
+bool BlockCache::IsCacheable(uint16_t address)
+{
+    return address <= 0x7fff || (address >= 0xc000 && address <= 0xdfff) || (address >= 0xff80 && address <= 0xfffe);
+}
+
+const DecodedInstruction *BlockCache::Fetch(uint16_t pc)
+{
+    if (generation != mem.code_generation || current_block == nullptr || pc != next_pc || current_index >= current_block->instructions.size())
+    {
+        if (Enter(pc) == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    const DecodedInstruction &instruction = current_block->instructions[current_index++];
+    next_pc += instruction.length;
+    return &instruction;
+}
+
+DecodedBlock *BlockCache::Enter(uint16_t pc)
+{
+    if (generation != mem.code_generation)
+    {
+        // Code was modified, a ROM bank was switched or the boot ROM was disabled
+        DropModifiedPages();
+        generation = mem.code_generation;
+    }
+
+    current_block = nullptr;
+
+    if (!IsCacheable(pc))
+    {
+        return nullptr;
+    }
+
+    uint32_t key = (static_cast<uint32_t>(mem.GetCodeBank(pc)) << 16) | pc;
+    auto it = blocks.find(key);
+    if (it == blocks.end())
+    {
+        DecodedBlock block = Decode(pc);
+        if (block.instructions.empty())
+        {
+            return nullptr;
+        }
+
+        if (pc >= 0x8000)
+        {
+            page_blocks[pc >> 8].push_back(key);
+            mem.MarkCodePage(pc >> 8);
+        }
+
+        it = blocks.emplace(key, std::move(block)).first;
+        decoded_blocks++;
+    }
+
+    current_block = &it->second;
+    current_index = 0;
+    next_pc = pc;
+    return &it->second;
+}
+
+void BlockCache::Clear()
+{
+    blocks.clear();
+    for (auto &keys : page_blocks)
+    {
+        keys.clear();
+    }
+    mem.modified_code_pages.fill(false);
+    current_block = nullptr;
+}
+
+void BlockCache::DropModifiedPages()
+{
+    for (int page = 0; page < 256; page++)
+    {
+        if (!mem.modified_code_pages[page])
+        {
+            continue;
+        }
+
+        for (uint32_t key : page_blocks[page])
+        {
+            blocks.erase(key);
+        }
+        page_blocks[page].clear();
+        mem.modified_code_pages[page] = false;
+    }
+}
+
+DecodedBlock BlockCache::Decode(uint16_t pc) const
+{
+    DecodedBlock block;
+    uint32_t address = pc;
+    const uint32_t page = pc >> 8;
+
+    while (block.instructions.size() < MaxBlockLength)
+    {
+        uint8_t opcode = mem.Read(address);
+        uint8_t length = instruction_lengths[opcode];
+
+        // Leave invalid opcodes and instructions crossing the page to the interpreter
+        uint32_t last_address = address + length - 1;
+        if (length == 0 || (last_address >> 8) != page || !IsCacheable(last_address))
+        {
+            break;
+        }
+
+        DecodedInstruction instruction;
+        instruction.code = CPU::opcode_table[opcode].code;
+        instruction.cycles = CPU::opcode_table[opcode].cycles;
+        instruction.opcode = opcode;
+        instruction.length = length;
+        for (uint8_t i = 1; i < length; i++)
+        {
+            instruction.operands[i - 1] = mem.Read(address + i);
+        }
+        block.instructions.push_back(instruction);
+
+        address += length;
+        if (block_ends[opcode] || (address >> 8) != page)
+        {
+            break;
+        }
+    }
+
+    return block;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../HostMemory.h"
+
+class CPU;
+
+/// An instruction with its opcode and operand bytes already read from memory, and its handler resolved.
+struct DecodedInstruction
+{
+    /// pointer to the function executing the instruction
+    void (CPU::*code)() = nullptr;
+    /// Base number of CPU cycles the instruction takes to execute
+    uint8_t cycles = 0;
+    uint8_t opcode = 0;
+    /// Number of bytes including the opcode (1-3)
+    uint8_t length = 1;
+    /// The bytes following the opcode, consumed by `CPU::fetch8BitValue` when the instruction is executed
+    uint8_t operands[2] = {0, 0};
+};
+
+/// A straight run of predecoded instructions
+struct DecodedBlock
+{
+    std::vector<DecodedInstruction> instructions;
+    /// Number of times execution entered the block at its first instruction. Only counted by `BlockCache::Enter`.
+    uint32_t entries = 0;
+    /// Native code for the block, compiled by the JIT once the block is hot (see jit_x64.h) or loaded from an AOT library (see aot.h)
+    void *native_code = nullptr;
+    /// Set when the JIT can't compile the block, so it doesn't try again
+    bool native_code_unsupported = false;
+    /// Total cycles of one pass through the native code
+    uint16_t native_cycles = 0;
+};
+
+/// Cache of predecoded basic blocks keyed by (code bank, PC).
+///
+/// A block is a straight run of instructions ending at the first instruction that can change the control flow (jumps, calls, returns, RST, HALT and STOP).
+/// Blocks never cross a 256 byte page, so a write to a RAM page holding decoded code only has to drop the blocks of that page.
+/// ROM blocks are keyed by the mapped ROM bank and are never dropped; a bank switch just makes lookups use the blocks of the new bank.
+///
+/// Only ROM, WRAM (0xc000 - 0xdfff) and HRAM (0xff80 - 0xfffe) are cached. Code anywhere else is read through HostMemory as usual.
+class BlockCache
+{
+public:
+    /// The longest block decoded, in instructions
+    static constexpr uint8_t MaxBlockLength = 32;
+
+    explicit BlockCache(HostMemory &mem) : mem(mem)
+    {
+    }
+
+    /// Returns the predecoded instruction at `pc`, decoding a new block if needed.
+    /// Consecutive calls walk through the current block without any lookups, as long as `pc` follows the previous instruction.
+    /// \returns nullptr if the code at `pc` can not be cached
+    const DecodedInstruction *Fetch(uint16_t pc);
+
+    /// Look up (or decode) the block starting at `pc`, and continue fetching from its first instruction.
+    /// \returns nullptr if the code at `pc` can not be cached
+    DecodedBlock *Enter(uint16_t pc);
+
+    /// Whether `pc` is the next instruction of the block currently being fetched from, past its first instruction.
+    [[nodiscard]] bool IsInsideBlock(uint16_t pc) const
+    {
+        return current_block != nullptr && current_index > 0 && pc == next_pc && current_index < current_block->instructions.size();
+    }
+
+    /// Drop all decoded blocks
+    void Clear();
+
+    /// Number of blocks decoded since creation. Useful for seeing how often code is invalidated.
+    uint64_t decoded_blocks = 0;
+
+private:
+    HostMemory &mem;
+    std::unordered_map<uint32_t, DecodedBlock> blocks;
+    /// Keys of the blocks decoded from each RAM page
+    std::array<std::vector<uint32_t>, 256> page_blocks;
+
+    const DecodedBlock *current_block = nullptr;
+    size_t current_index = 0;
+    uint16_t next_pc = 0;
+    uint32_t generation = 0;
+
+    static bool IsCacheable(uint16_t address);
+    void DropModifiedPages();
+    DecodedBlock Decode(uint16_t pc) const;
+};
@@ -3,299 +3,302 @@
 #include <stdarg.h>
 
 #include "cpu.h"
-
-CPU::CPU(HostMemory &memref) : mem(memref)
+#include "native_block.h"
+
+// Based on tables from:
+// https://clrhome.org/table/
+// https://www.pastraiser.com/cpu/gameboy/gameboy_opcodes.html
+
+constexpr std::array<CPU::Instruction, 256> CPU::opcode_table = {{
+    {4, &CPU::NOP},        // 0x00 NOP
+    {12, &CPU::LD_BC_nn},  // 0x01 LD BC,NN
+    {8, &CPU::LD_pBC_A},   // 0x02 "LD (BC),A"
+    {8, &CPU::INC_BC},     // 0x03 "INC BC"
+    {4, &CPU::INC_B},      // 0x04 "INC B"
+    {4, &CPU::DEC_B},      // 0x05 "DEC B"
+    {8, &CPU::LD_r_n},     // 0x06 "LD B,N"
+    {4, &CPU::RLCA},       // 0x07 "RLCA"
+    {20, &CPU::LD_pnn_SP}, // 0x08 "LD_(nnnn),SP"
+    {8, &CPU::ADD_HL_BC},  // 0x09 "ADD HL,BC"
+    {8, &CPU::LD_A_pBC},   // 0x0a "LD A,(BC)"
+    {8, &CPU::DEC_BC},     // 0x0b "DEC BC"
+    {4, &CPU::INC_C},      // 0x0c "INC C"
+    {4, &CPU::DEC_C},      // 0x0d "DEC C"
+    {8, &CPU::LD_r_n},     // 0x0e "LD C,N"
+    {4, &CPU::RRCA},       // 0x0f "RRCA"
+
+    {4, &CPU::STOP},      // 0x10 "STOP"
+    {12, &CPU::LD_DE_nn}, // 0x11 "LD DE,NN"
+    {8, &CPU::LD_pDE_A},  // 0x12 "LD (DE),A"
+    {8, &CPU::INC_DE},    // 0x13 "INC DE"
+    {4, &CPU::INC_D},     // 0x14 "INC D"
+    {4, &CPU::DEC_D},     // 0x15 "DEC D"
+    {8, &CPU::LD_r_n},    // 0x16 "LD D,N"
+    {4, &CPU::RLA},       // 0x17 "RLA"
+    {12, &CPU::JR_n},     // 0x18 "JR N"
+    {8, &CPU::ADD_HL_DE}, // 0x19 "ADD HL,DE"
+    {8, &CPU::LD_A_pDE},  // 0x1a "LD A,(DE)"
+    {8, &CPU::DEC_DE},    // 0x1b "DEC DE"
+    {4, &CPU::INC_E},     // 0x1c "INC E"
+    {4, &CPU::DEC_E},     // 0x1d "DEC E"
+    {8, &CPU::LD_r_n},    // 0x1e "LD E,N"
+    {4, &CPU::RRA},       // 0x1f "RRA"
+
+    {8, &CPU::JR_nz},     // 0x20 "JR NZ"
+    {12, &CPU::LD_HL_nn}, // 0x21 "LD HL,NN"
+    {8, &CPU::LDI_pHL_A}, // 0x22 "LD (NN),HL"
+    {8, &CPU::INC_HL},    // 0x23 "INC HL"
+    {4, &CPU::INC_H},     // 0x24 "INC H"
+    {4, &CPU::DEC_H},     // 0x25 "DEC H"
+    {8, &CPU::LD_r_n},    // 0x26 "LD H,N"
+    {4, &CPU::daa},       // 0x27 "DAA"
+    {8, &CPU::JR_z},      // 0x28 "JR Z"
+    {8, &CPU::ADD_HL_HL}, // 0x29 "ADD HL,HL"
+    {8, &CPU::LDI_A_pHL}, // 0x2a "LD HL,(NN)"
+    {8, &CPU::DEC_HL},    // 0x2b "DEC HL"
+    {4, &CPU::INC_L},     // 0x2c "INC L"
+    {4, &CPU::DEC_L},     // 0x2d "DEC L"
+    {8, &CPU::LD_r_n},    // 0x2e "LD L,N"
+    {4, &CPU::cpl},       // 0x2f "CPL"
+
+    {8, &CPU::JR_nc},     // 0x30 "JR NC",
+    {12, &CPU::LD_SP_nn}, // 0x31 "LD SP,NN",
+    {8, &CPU::LDD_pHL_A}, // 0x32 "LD (NN),A"
+    {8, &CPU::INC_SP},    // 0x33 "INC SP"
+    {12, &CPU::INC_pHL},  // 0x34 "INC (HL)"
+    {12, &CPU::DEC_pHL},  // 0x35 "DEC (HL)"
+    {12, &CPU::LD_pHL_n}, // 0x36 "LD (HL),N"
+    {4, &CPU::scf},       // 0x37 "SCF"
+    {12, &CPU::JR_c},     // 0x38 "JR C,N"
+    {8, &CPU::ADD_HL_SP}, // 0x39 "ADD HL,SP"
+    {8, &CPU::LDD_A_pHL}, // 0x3a "LD A,(NN)"
+    {8, &CPU::DEC_SP},    // 0x3b "DEC SP"
+    {4, &CPU::INC_A},     // 0x3c {"INC A"
+    {4, &CPU::DEC_A},     // 0x3d "DEC A"
+    {8, &CPU::LD_r_n},    // 0x3e "LD A,N"
+    {4, &CPU::ccf},       // 0x3f "CCF"
+
+    {4, &CPU::LD_r_r<B, B>}, // 0x40 "LD B,B"
+    {4, &CPU::LD_r_r<B, C>}, // 0x41 "LD B,C"
+    {4, &CPU::LD_r_r<B, D>}, // 0x42 "LD B,D"
+    {4, &CPU::LD_r_r<B, E>}, // 0x43 "LD B,E"
+    {4, &CPU::LD_r_r<B, H>}, // 0x44 "LD B,H"
+    {4, &CPU::LD_r_r<B, L>}, // 0x45 "LD B,L"
+    {8, &CPU::LD_r_r<B, HLPtr>}, // 0x46 "LD B,(hl)"
+    {4, &CPU::LD_r_r<B, A>}, // 0x47 "LD B,A"
+    {4, &CPU::LD_r_r<C, B>}, // 0x48 "LD C,B"
+    {4, &CPU::LD_r_r<C, C>}, // 0x49 "LD C,C"
+    {4, &CPU::LD_r_r<C, D>}, // 0x4a "LD C,D"
+    {4, &CPU::LD_r_r<C, E>}, // 0x4b "LD C,E"
+    {4, &CPU::LD_r_r<C, H>}, // 0x4c "LD C,H"
+    {4, &CPU::LD_r_r<C, L>}, // 0x4d "LD C,L"
+    {8, &CPU::LD_r_r<C, HLPtr>}, // 0x4e "LD C,(HL)"
+    {4, &CPU::LD_r_r<C, A>}, // 0x4f "LD C,A"
+
+    {4, &CPU::LD_r_r<D, B>}, // 0x50 "LD D,B"
+    {4, &CPU::LD_r_r<D, C>}, // 0x51 "LD D,C"
+    {4, &CPU::LD_r_r<D, D>}, // 0x52 "LD D,D"
+    {4, &CPU::LD_r_r<D, E>}, // 0x53 "LD D,E"
+    {4, &CPU::LD_r_r<D, H>}, // 0x54 "LD D,H"
+    {4, &CPU::LD_r_r<D, L>}, // 0x55 "LD D,L"
+    {8, &CPU::LD_r_r<D, HLPtr>}, // 0x56 "LD D,(HL)"
+    {4, &CPU::LD_r_r<D, A>}, // 0x57 "LD D,A"
+    {4, &CPU::LD_r_r<E, B>}, // 0x58 "LD E,B"
+    {4, &CPU::LD_r_r<E, C>}, // 0x59 "LD E,C"
+    {4, &CPU::LD_r_r<E, D>}, // 0x5a "LD E,D"
+    {4, &CPU::LD_r_r<E, E>}, // 0x5b "LD E,E"
+    {4, &CPU::LD_r_r<E, H>}, // 0x5c "LD E,H"
+    {4, &CPU::LD_r_r<E, L>}, // 0x5d "LD E,L"
+    {8, &CPU::LD_r_r<E, HLPtr>}, // 0x5e "LD E,(HL)"
+    {4, &CPU::LD_r_r<E, A>}, // 0x5f "LD E,A"
+
+    {4, &CPU::LD_r_r<H, B>}, // 0x60 "LD H,B"
+    {4, &CPU::LD_r_r<H, C>}, // 0x61 "LD H,C"
+    {4, &CPU::LD_r_r<H, D>}, // 0x62 "LD H,D"
+    {4, &CPU::LD_r_r<H, E>}, // 0x63 "LD H,E"
+    {4, &CPU::LD_r_r<H, H>}, // 0x64 "LD H,H"
+    {4, &CPU::LD_r_r<H, L>}, // 0x65 "LD H,L"
+    {8, &CPU::LD_r_r<H, HLPtr>}, // 0x66 "LD H,(HL)"
+    {4, &CPU::LD_r_r<H, A>}, // 0x67 "LD H,A"
+    {4, &CPU::LD_r_r<L, B>}, // 0x68 "LD L,B"
+    {4, &CPU::LD_r_r<L, C>}, // 0x69 "LD L,C"
+    {4, &CPU::LD_r_r<L, D>}, // 0x6a "LD L,D"
+    {4, &CPU::LD_r_r<L, E>}, // 0x6b "LD L,E"
+    {4, &CPU::LD_r_r<L, H>}, // 0x6c "LD L,H"
+    {4, &CPU::LD_r_r<L, L>}, // 0x6d "LD L,L"
+    {8, &CPU::LD_r_r<L, HLPtr>}, // 0x6e "LD L,(HL)"
+    {4, &CPU::LD_r_r<L, A>}, // 0x6f "LD L,A
+
+    {8, &CPU::LD_r_r<HLPtr, B>}, // 0x70 "LD R,R"
+    {8, &CPU::LD_r_r<HLPtr, C>}, // 0x71 "LD R,R"
+    {8, &CPU::LD_r_r<HLPtr, D>}, // 0x72 "LD R,R"
+    {8, &CPU::LD_r_r<HLPtr, E>}, // 0x73 "LD R,R"
+    {8, &CPU::LD_r_r<HLPtr, H>}, // 0x74 "LD R,R"
+    {8, &CPU::LD_r_r<HLPtr, L>}, // 0x75 "LD R,R"
+    {4, &CPU::halt},   // 0x76 "HALT"
+    {8, &CPU::LD_r_r<HLPtr, A>}, // 0x77 "LD R,R"
+    {4, &CPU::LD_r_r<A, B>}, // 0x78 "LD R,R"
+    {4, &CPU::LD_r_r<A, C>}, // 0x79 "LD R,R"
+    {4, &CPU::LD_r_r<A, D>}, // 0x7a "LD R,R"
+    {4, &CPU::LD_r_r<A, E>}, // 0x7b "LD R,R"
+    {4, &CPU::LD_r_r<A, H>}, // 0x7c "LD R,R"
+    {4, &CPU::LD_r_r<A, L>}, // 0x7d "LD R,R"
+    {8, &CPU::LD_r_r<A, HLPtr>}, // 0x7e "LD R,R"
+    {4, &CPU::LD_r_r<A, A>}, // 0x7f "LD R,R"
+
+    {4, &CPU::ADD_A_r<B>}, // 0x80 "ADD A,B"
+    {4, &CPU::ADD_A_r<C>}, // 0x81 "ADD A,C"
+    {4, &CPU::ADD_A_r<D>}, // 0x82 "ADD A,D"
+    {4, &CPU::ADD_A_r<E>}, // 0x83 "ADD A,E"
+    {4, &CPU::ADD_A_r<H>}, // 0x84 "ADD A,H"
+    {4, &CPU::ADD_A_r<L>}, // 0x85 "ADD A,L"
+    {8, &CPU::ADD_A_r<HLPtr>}, // 0x86 "ADD A,(HL)"
+    {4, &CPU::ADD_A_r<A>}, // 0x87 "ADD A,A"
+
+    {4, &CPU::ADC_A_r<B>}, // 0x88 "ADC A,B"
+    {4, &CPU::ADC_A_r<C>}, // 0x89 "ADC A,C"
+    {4, &CPU::ADC_A_r<D>}, // 0x8a "ADC A,D"
+    {4, &CPU::ADC_A_r<E>}, // 0x8b "ADC A,E"
+    {4, &CPU::ADC_A_r<H>}, // 0x8c "ADC A,H"
+    {4, &CPU::ADC_A_r<L>}, // 0x8d "ADC A,L"
+    {8, &CPU::ADC_A_r<HLPtr>}, // 0x8e "ADC A,(HL)"
+    {4, &CPU::ADC_A_r<A>}, // 0x8f "ADC A,A"
+
+    {4, &CPU::SUB_r<B>}, // 0x90 "SUB B"
+    {4, &CPU::SUB_r<C>}, // 0x91 "SUB C"
+    {4, &CPU::SUB_r<D>}, // 0x92 "SUB D"
+    {4, &CPU::SUB_r<E>}, // 0x93 "SUB E"
+    {4, &CPU::SUB_r<H>}, // 0x94 "SUB H"
+    {4, &CPU::SUB_r<L>}, // 0x95 "SUB L"
+    {8, &CPU::SUB_r<HLPtr>}, // 0x96 "SUB (HL)"
+    {4, &CPU::SUB_r<A>}, // 0x97 "SUB A"
+
+    {4, &CPU::SBC_r<B>}, // 0x98 "SBC B"
+    {4, &CPU::SBC_r<C>}, // 0x99 "SBC C"
+    {4, &CPU::SBC_r<D>}, // 0x9a "SBC D"
+    {4, &CPU::SBC_r<E>}, // 0x9b "SBC E"
+    {4, &CPU::SBC_r<H>}, // 0x9c "SBC H"
+    {4, &CPU::SBC_r<L>}, // 0x9d "SBC L"
+    {8, &CPU::SBC_r<HLPtr>}, // 0x9e "SBC (HL)"
+    {4, &CPU::SBC_r<A>}, // 0x9f "SBC A"
+
+    {4, &CPU::AND_r<B>}, // 0xa0 "AND B"
+    {4, &CPU::AND_r<C>}, // 0xa1 "AND C"
+    {4, &CPU::AND_r<D>}, // 0xa2 "AND D"
+    {4, &CPU::AND_r<E>}, // 0xa3 "AND E"
+    {4, &CPU::AND_r<H>}, // 0xa4 "AND H"
+    {4, &CPU::AND_r<L>}, // 0xa5 "AND L"
+    {8, &CPU::AND_r<HLPtr>}, // 0xa6 "AND (HL)"
+    {4, &CPU::AND_r<A>}, // 0xa7 "AND A"
+
+    {4, &CPU::XOR_r<B>}, // 0xa8 "XOR B"
+    {4, &CPU::XOR_r<C>}, // 0xa9 "XOR C"
+    {4, &CPU::XOR_r<D>}, // 0xaa "XOR D"
+    {4, &CPU::XOR_r<E>}, // 0xab "XOR E"
+    {4, &CPU::XOR_r<H>}, // 0xac "XOR H"
+    {4, &CPU::XOR_r<L>}, // 0xad "XOR L"
+    {8, &CPU::XOR_r<HLPtr>}, // 0xae "XOR (HL)"
+    {4, &CPU::XOR_r<A>}, // 0xaf "XOR A"
+
+    {4, &CPU::OR_r<B>}, // 0xb0 "OR B"
+    {4, &CPU::OR_r<C>}, // 0xb1 "OR C"
+    {4, &CPU::OR_r<D>}, // 0xb2 "OR D"
+    {4, &CPU::OR_r<E>}, // 0xb3 "OR E"
+    {4, &CPU::OR_r<H>}, // 0xb4 "OR H"
+    {4, &CPU::OR_r<L>}, // 0xb5 "OR L"
+    {8, &CPU::OR_r<HLPtr>}, // 0xb6 "OR (HL)"
+    {4, &CPU::OR_r<A>}, // 0xb7 "OR A"
+
+    {4, &CPU::CP_r<B>}, // 0xb8 "CP B"
+    {4, &CPU::CP_r<C>}, // 0xb9 "CP C"
+    {4, &CPU::CP_r<D>}, // 0xba "CP D"
+    {4, &CPU::CP_r<E>}, // 0xbb "CP E"
+    {4, &CPU::CP_r<H>}, // 0xbc "CP H"
+    {4, &CPU::CP_r<L>}, // 0xbd "CP L"
+    {8, &CPU::CP_r<HLPtr>}, // 0xbe "CP (HL)"
+    {4, &CPU::CP_r<A>}, // 0xbf "CP A"
+
+    {8, &CPU::RET_cc},                 // 0xc0 "RET NZ"
+    {12, &CPU::pop_qq},                // 0xc1 "POP BC"
+    {12, &CPU::JP_cc_nn},              // 0xc2 "JP NZ NN"
+    {16, &CPU::JP_nn},                 // 0xc3 "JP NN"
+    {12, &CPU::CALL_cc_nn},            // 0xc4 "CALL NZ,NN"
+    {16, &CPU::push_bc},               // 0xc5 "PUSH BC"
+    {8, &CPU::ADD_A_n},                // 0xc6 "ADD A,n"
+    {16, &CPU::RST},                   // 0xc7 "RST 00h"
+    {8, &CPU::RET_cc},                 // 0xc8 "RET Z"
+    {16, &CPU::RET},                   // 0xc9 "RET"
+    {12, &CPU::JP_cc_nn},              // 0xca "JP Z,**"
+    {4, &CPU::decode_bit_instruction}, // 0xcb "BIT opcode group"
+    {12, &CPU::CALL_cc_nn},            // 0xcc "CALL Z,nn"
+    {24, &CPU::CALL},                  // 0xcd "CALL nn"
+    {8, &CPU::ADC_A_n},                // 0xce "ADC A,N"
+    {16, &CPU::RST},                   // 0xcf "RST 08h"
+
+    {8, &CPU::RET_cc},         // 0xd0 "RET NC"
+    {12, &CPU::pop_qq},        // 0xd1 "POP DE"
+    {12, &CPU::JP_cc_nn},      // 0xd2 "JP NC,NN"
+    {0, &CPU::invalid_opcode}, // 0xd3 "OUT (N),A"
+    {12, &CPU::CALL_cc_nn},    // 0xd4 "CALL NC,NN"
+    {16, &CPU::push_de},       // 0xd5 "PUSH DE"
+    {8, &CPU::SUB_n},          // 0xd6 "SUB N"
+    {16, &CPU::RST},           // 0xd7 "RST 10h"
+    {8, &CPU::RET_cc},         // 0xd8 "RET C"
+    {16, &CPU::RETI},          // 0xd9 "EXX"
+    {12, &CPU::JP_cc_nn},      // 0xda "JP C,NN"
+    {0, &CPU::invalid_opcode}, // 0xdb
+    {12, &CPU::CALL_cc_nn},    // 0xdc "CALL C,NN"
+    {0, &CPU::invalid_opcode}, // 0xdd
+    {8, &CPU::SBC_n},          // 0xde "SBC N"
+    {16, &CPU::RST},           // 0xdf "RST 18h"
+
+    {12, &CPU::LD_ff00n_A},    // 0xe0 LD_ff00 + n, A
+    {12, &CPU::pop_qq},        // 0xe1 "POP HL"
+    {8, &CPU::LD_ff00C_A},     // 0xe2 "JP PO,NN"
+    {0, &CPU::invalid_opcode}, // 0xe3 -
+    {0, &CPU::invalid_opcode}, // 0xe4 -
+    {16, &CPU::push_hl},       // 0xe5 "PUSH HL"
+    {8, &CPU::AND_n},          // 0xe6 "AND N"
+    {16, &CPU::RST},           // 0xe7 "RST 20h"
+    {16, &CPU::ADD_SP_s8},     // 0xe8 "RET PE"
+    {4, &CPU::JP_pHL},         // 0xe9 "JP (HL)"
+    {16, &CPU::LD_pnn_A},      // 0xea "LD (nn),A"
+    {0, &CPU::invalid_opcode}, // 0xeb
+    {0, &CPU::invalid_opcode}, // 0xec
+    {0, &CPU::invalid_opcode}, // 0xed
+    {8, &CPU::XOR_n},          // 0xee "XOR N"
+    {16, &CPU::RST},           // 0xef "RST 28h"
+
+    {12, &CPU::LD_A_ff00n},        // 0xf0 "RET P"
+    {12, &CPU::pop_qq},            // 0xf1 "POP AF"
+    {8, &CPU::LD_A_ff00C},         // 0xf2 "JP P,NN"
+    {4, &CPU::disable_interrupts}, // 0xf3 "DI"
+    {0, &CPU::invalid_opcode},     // 0xf4
+    {16, &CPU::push_af},           // 0xf5 "PUSH AF"
+    {8, &CPU::OR_n},               // 0xf6 "OR N"
+    {16, &CPU::RST},               // 0xf7 "RST 30h"
+    {12, &CPU::LD_HL_SPs8},        // 0xf8 "LD HL,SP+s8"
+    {8, &CPU::ld_sp_hl},           // 0xf9 "LD SP,HL"
+    {16, &CPU::LD_A_pnnnn},        // 0xfa "LD A,(nnnn)"
+    {4, &CPU::enable_interrupts},  // 0xfb "EI"
+    {0, &CPU::invalid_opcode},     // 0xfc
+    {0, &CPU::invalid_opcode},     // 0xfd
+    {8, &CPU::CP_n},               // 0xfe "CP N"
+    {16, &CPU::RST}                // 0xff "RST 38h"
+}};
+
+CPU::CPU(HostMemory &memref) : instructions(opcode_table.begin(), opcode_table.end()), mem(memref), block_cache(memref), idle_loop(memref)
 {
-
-    // Based on tables from:
-    // https://clrhome.org/table/
-    // https://www.pastraiser.com/cpu/gameboy/gameboy_opcodes.html
-
-    instructions = {
-        {4, &CPU::NOP},        // 0x00 NOP
-        {12, &CPU::LD_BC_nn},  // 0x01 LD BC,NN
-        {8, &CPU::LD_pBC_A},   // 0x02 "LD (BC),A"
-        {8, &CPU::INC_BC},     // 0x03 "INC BC"
-        {4, &CPU::INC_B},      // 0x04 "INC B"
-        {4, &CPU::DEC_B},      // 0x05 "DEC B"
-        {8, &CPU::LD_r_n},     // 0x06 "LD B,N"
-        {4, &CPU::RLCA},       // 0x07 "RLCA"
-        {20, &CPU::LD_pnn_SP}, // 0x08 "LD_(nnnn),SP"
-        {8, &CPU::ADD_HL_BC},  // 0x09 "ADD HL,BC"
-        {8, &CPU::LD_A_pBC},   // 0x0a "LD A,(BC)"
-        {8, &CPU::DEC_BC},     // 0x0b "DEC BC"
-        {4, &CPU::INC_C},      // 0x0c "INC C"
-        {4, &CPU::DEC_C},      // 0x0d "DEC C"
-        {8, &CPU::LD_r_n},     // 0x0e "LD C,N"
-        {4, &CPU::RRCA},       // 0x0f "RRCA"
-
-        {4, &CPU::STOP},      // 0x10 "STOP"
-        {12, &CPU::LD_DE_nn}, // 0x11 "LD DE,NN"
-        {8, &CPU::LD_pDE_A},  // 0x12 "LD (DE),A"
-        {8, &CPU::INC_DE},    // 0x13 "INC DE"
-        {4, &CPU::INC_D},     // 0x14 "INC D"
-        {4, &CPU::DEC_D},     // 0x15 "DEC D"
-        {8, &CPU::LD_r_n},    // 0x16 "LD D,N"
-        {4, &CPU::RLA},       // 0x17 "RLA"
-        {12, &CPU::JR_n},     // 0x18 "JR N"
-        {8, &CPU::ADD_HL_DE}, // 0x19 "ADD HL,DE"
-        {8, &CPU::LD_A_pDE},  // 0x1a "LD A,(DE)"
-        {8, &CPU::DEC_DE},    // 0x1b "DEC DE"
-        {4, &CPU::INC_E},     // 0x1c "INC E"
-        {4, &CPU::DEC_E},     // 0x1d "DEC E"
-        {8, &CPU::LD_r_n},    // 0x1e "LD E,N"
-        {4, &CPU::RRA},       // 0x1f "RRA"
-
-        {8, &CPU::JR_nz},     // 0x20 "JR NZ"
-        {12, &CPU::LD_HL_nn}, // 0x21 "LD HL,NN"
-        {8, &CPU::LDI_pHL_A}, // 0x22 "LD (NN),HL"
-        {8, &CPU::INC_HL},    // 0x23 "INC HL"
-        {4, &CPU::INC_H},     // 0x24 "INC H"
-        {4, &CPU::DEC_H},     // 0x25 "DEC H"
-        {8, &CPU::LD_r_n},    // 0x26 "LD H,N"
-        {4, &CPU::daa},       // 0x27 "DAA"
-        {8, &CPU::JR_z},      // 0x28 "JR Z"
-        {8, &CPU::ADD_HL_HL}, // 0x29 "ADD HL,HL"
-        {8, &CPU::LDI_A_pHL}, // 0x2a "LD HL,(NN)"
-        {8, &CPU::DEC_HL},    // 0x2b "DEC HL"
-        {4, &CPU::INC_L},     // 0x2c "INC L"
-        {4, &CPU::DEC_L},     // 0x2d "DEC L"
-        {8, &CPU::LD_r_n},    // 0x2e "LD L,N"
-        {4, &CPU::cpl},       // 0x2f "CPL"
-
-        {8, &CPU::JR_nc},     // 0x30 "JR NC",
-        {12, &CPU::LD_SP_nn}, // 0x31 "LD SP,NN",
-        {8, &CPU::LDD_pHL_A}, // 0x32 "LD (NN),A"
-        {8, &CPU::INC_SP},    // 0x33 "INC SP"
-        {12, &CPU::INC_pHL},  // 0x34 "INC (HL)"
-        {12, &CPU::DEC_pHL},  // 0x35 "DEC (HL)"
-        {12, &CPU::LD_pHL_n}, // 0x36 "LD (HL),N"
-        {4, &CPU::scf},       // 0x37 "SCF"
-        {12, &CPU::JR_c},     // 0x38 "JR C,N"
-        {8, &CPU::ADD_HL_SP}, // 0x39 "ADD HL,SP"
-        {8, &CPU::LDD_A_pHL}, // 0x3a "LD A,(NN)"
-        {8, &CPU::DEC_SP},    // 0x3b "DEC SP"
-        {4, &CPU::INC_A},     // 0x3c {"INC A"
-        {4, &CPU::DEC_A},     // 0x3d "DEC A"
-        {8, &CPU::LD_r_n},    // 0x3e "LD A,N"
-        {4, &CPU::ccf},       // 0x3f "CCF"
-
-        {4, &CPU::LD_r_r}, // 0x40 "LD B,B"
-        {4, &CPU::LD_r_r}, // 0x41 "LD B,C"
-        {4, &CPU::LD_r_r}, // 0x42 "LD B,D"
-        {4, &CPU::LD_r_r}, // 0x43 "LD B,E"
-        {4, &CPU::LD_r_r}, // 0x44 "LD B,H"
-        {4, &CPU::LD_r_r}, // 0x45 "LD B,L"
-        {8, &CPU::LD_r_r}, // 0x46 "LD B,(hl)"
-        {4, &CPU::LD_r_r}, // 0x47 "LD B,A"
-        {4, &CPU::LD_r_r}, // 0x48 "LD C,B"
-        {4, &CPU::LD_r_r}, // 0x49 "LD C,C"
-        {4, &CPU::LD_r_r}, // 0x4a "LD C,D"
-        {4, &CPU::LD_r_r}, // 0x4b "LD C,E"
-        {4, &CPU::LD_r_r}, // 0x4c "LD C,H"
-        {4, &CPU::LD_r_r}, // 0x4d "LD C,L"
-        {8, &CPU::LD_r_r}, // 0x4e "LD C,(HL)"
-        {4, &CPU::LD_r_r}, // 0x4f "LD C,A"
-
-        {4, &CPU::LD_r_r}, // 0x50 "LD D,B"
-        {4, &CPU::LD_r_r}, // 0x51 "LD D,C"
-        {4, &CPU::LD_r_r}, // 0x52 "LD D,D"
-        {4, &CPU::LD_r_r}, // 0x53 "LD D,E"
-        {4, &CPU::LD_r_r}, // 0x54 "LD D,H"
-        {4, &CPU::LD_r_r}, // 0x55 "LD D,L"
-        {8, &CPU::LD_r_r}, // 0x56 "LD D,(HL)"
-        {4, &CPU::LD_r_r}, // 0x57 "LD D,A"
-        {4, &CPU::LD_r_r}, // 0x58 "LD E,B"
-        {4, &CPU::LD_r_r}, // 0x59 "LD E,C"
-        {4, &CPU::LD_r_r}, // 0x5a "LD E,D"
-        {4, &CPU::LD_r_r}, // 0x5b "LD E,E"
-        {4, &CPU::LD_r_r}, // 0x5c "LD E,H"
-        {4, &CPU::LD_r_r}, // 0x5d "LD E,L"
-        {8, &CPU::LD_r_r}, // 0x5e "LD E,(HL)"
-        {4, &CPU::LD_r_r}, // 0x5f "LD E,A"
-
-        {4, &CPU::LD_r_r}, // 0x60 "LD H,B"
-        {4, &CPU::LD_r_r}, // 0x61 "LD H,C"
-        {4, &CPU::LD_r_r}, // 0x62 "LD H,D"
-        {4, &CPU::LD_r_r}, // 0x63 "LD H,E"
-        {4, &CPU::LD_r_r}, // 0x64 "LD H,H"
-        {4, &CPU::LD_r_r}, // 0x65 "LD H,L"
-        {8, &CPU::LD_r_r}, // 0x66 "LD H,(HL)"
-        {4, &CPU::LD_r_r}, // 0x67 "LD H,A"
-        {4, &CPU::LD_r_r}, // 0x68 "LD L,B"
-        {4, &CPU::LD_r_r}, // 0x69 "LD L,C"
-        {4, &CPU::LD_r_r}, // 0x6a "LD L,D"
-        {4, &CPU::LD_r_r}, // 0x6b "LD L,E"
-        {4, &CPU::LD_r_r}, // 0x6c "LD L,H"
-        {4, &CPU::LD_r_r}, // 0x6d "LD L,L"
-        {8, &CPU::LD_r_r}, // 0x6e "LD L,(HL)"
-        {4, &CPU::LD_r_r}, // 0x6f "LD L,A
-
-        {8, &CPU::LD_r_r}, // 0x70 "LD R,R"
-        {8, &CPU::LD_r_r}, // 0x71 "LD R,R"
-        {8, &CPU::LD_r_r}, // 0x72 "LD R,R"
-        {8, &CPU::LD_r_r}, // 0x73 "LD R,R"
-        {8, &CPU::LD_r_r}, // 0x74 "LD R,R"
-        {8, &CPU::LD_r_r}, // 0x75 "LD R,R"
-        {4, &CPU::halt},   // 0x76 "HALT"
-        {8, &CPU::LD_r_r}, // 0x77 "LD R,R"
-        {4, &CPU::LD_r_r}, // 0x78 "LD R,R"
-        {4, &CPU::LD_r_r}, // 0x79 "LD R,R"
-        {4, &CPU::LD_r_r}, // 0x7a "LD R,R"
-        {4, &CPU::LD_r_r}, // 0x7b "LD R,R"
-        {4, &CPU::LD_r_r}, // 0x7c "LD R,R"
-        {4, &CPU::LD_r_r}, // 0x7d "LD R,R"
-        {8, &CPU::LD_r_r}, // 0x7e "LD R,R"
-        {4, &CPU::LD_r_r}, // 0x7f "LD R,R"
-
-        {4, &CPU::ADD_A_r}, // 0x80 "ADD A,B"
-        {4, &CPU::ADD_A_r}, // 0x81 "ADD A,C"
-        {4, &CPU::ADD_A_r}, // 0x82 "ADD A,D"
-        {4, &CPU::ADD_A_r}, // 0x83 "ADD A,E"
-        {4, &CPU::ADD_A_r}, // 0x84 "ADD A,H"
-        {4, &CPU::ADD_A_r}, // 0x85 "ADD A,L"
-        {8, &CPU::ADD_A_r}, // 0x86 "ADD A,(HL)"
-        {4, &CPU::ADD_A_r}, // 0x87 "ADD A,A"
-
-        {4, &CPU::ADC_A_r}, // 0x88 "ADC A,B"
-        {4, &CPU::ADC_A_r}, // 0x89 "ADC A,C"
-        {4, &CPU::ADC_A_r}, // 0x8a "ADC A,D"
-        {4, &CPU::ADC_A_r}, // 0x8b "ADC A,E"
-        {4, &CPU::ADC_A_r}, // 0x8c "ADC A,H"
-        {4, &CPU::ADC_A_r}, // 0x8d "ADC A,L"
-        {8, &CPU::ADC_A_r}, // 0x8e "ADC A,(HL)"
-        {4, &CPU::ADC_A_r}, // 0x8f "ADC A,A"
-
-        {4, &CPU::SUB_r}, // 0x90 "SUB B"
-        {4, &CPU::SUB_r}, // 0x91 "SUB C"
-        {4, &CPU::SUB_r}, // 0x92 "SUB D"
-        {4, &CPU::SUB_r}, // 0x93 "SUB E"
-        {4, &CPU::SUB_r}, // 0x94 "SUB H"
-        {4, &CPU::SUB_r}, // 0x95 "SUB L"
-        {8, &CPU::SUB_r}, // 0x96 "SUB (HL)"
-        {4, &CPU::SUB_r}, // 0x97 "SUB A"
-
-        {4, &CPU::SBC_r}, // 0x98 "SBC B"
-        {4, &CPU::SBC_r}, // 0x99 "SBC C"
-        {4, &CPU::SBC_r}, // 0x9a "SBC D"
-        {4, &CPU::SBC_r}, // 0x9b "SBC E"
-        {4, &CPU::SBC_r}, // 0x9c "SBC H"
-        {4, &CPU::SBC_r}, // 0x9d "SBC L"
-        {8, &CPU::SBC_r}, // 0x9e "SBC (HL)"
-        {4, &CPU::SBC_r}, // 0x9f "SBC A"
-
-        {4, &CPU::AND_r}, // 0xa0 "AND B"
-        {4, &CPU::AND_r}, // 0xa1 "AND C"
-        {4, &CPU::AND_r}, // 0xa2 "AND D"
-        {4, &CPU::AND_r}, // 0xa3 "AND E"
-        {4, &CPU::AND_r}, // 0xa4 "AND H"
-        {4, &CPU::AND_r}, // 0xa5 "AND L"
-        {8, &CPU::AND_r}, // 0xa6 "AND (HL)"
-        {4, &CPU::AND_r}, // 0xa7 "AND A"
-
-        {4, &CPU::XOR_r}, // 0xa8 "XOR B"
-        {4, &CPU::XOR_r}, // 0xa9 "XOR C"
-        {4, &CPU::XOR_r}, // 0xaa "XOR D"
-        {4, &CPU::XOR_r}, // 0xab "XOR E"
-        {4, &CPU::XOR_r}, // 0xac "XOR H"
-        {4, &CPU::XOR_r}, // 0xad "XOR L"
-        {8, &CPU::XOR_r}, // 0xae "XOR (HL)"
-        {4, &CPU::XOR_r}, // 0xaf "XOR A"
-
-        {4, &CPU::OR_r}, // 0xb0 "OR B"
-        {4, &CPU::OR_r}, // 0xb1 "OR C"
-        {4, &CPU::OR_r}, // 0xb2 "OR D"
-        {4, &CPU::OR_r}, // 0xb3 "OR E"
-        {4, &CPU::OR_r}, // 0xb4 "OR H"
-        {4, &CPU::OR_r}, // 0xb5 "OR L"
-        {8, &CPU::OR_r}, // 0xb6 "OR (HL)"
-        {4, &CPU::OR_r}, // 0xb7 "OR A"
-
-        {4, &CPU::CP_r}, // 0xb8 "CP B"
-        {4, &CPU::CP_r}, // 0xb9 "CP C"
-        {4, &CPU::CP_r}, // 0xba "CP D"
-        {4, &CPU::CP_r}, // 0xbb "CP E"
-        {4, &CPU::CP_r}, // 0xbc "CP H"
-        {4, &CPU::CP_r}, // 0xbd "CP L"
-        {8, &CPU::CP_r}, // 0xbe "CP (HL)"
-        {4, &CPU::CP_r}, // 0xbf "CP A"
-
-        {8, &CPU::RET_cc},                 // 0xc0 "RET NZ"
-        {12, &CPU::pop_qq},                // 0xc1 "POP BC"
-        {12, &CPU::JP_cc_nn},              // 0xc2 "JP NZ NN"
-        {16, &CPU::JP_nn},                 // 0xc3 "JP NN"
-        {12, &CPU::CALL_cc_nn},            // 0xc4 "CALL NZ,NN"
-        {16, &CPU::push_bc},               // 0xc5 "PUSH BC"
-        {8, &CPU::ADD_A_n},                // 0xc6 "ADD A,n"
-        {16, &CPU::RST},                   // 0xc7 "RST 00h"
-        {8, &CPU::RET_cc},                 // 0xc8 "RET Z"
-        {16, &CPU::RET},                   // 0xc9 "RET"
-        {12, &CPU::JP_cc_nn},              // 0xca "JP Z,**"
-        {4, &CPU::decode_bit_instruction}, // 0xcb "BIT opcode group"
-        {12, &CPU::CALL_cc_nn},            // 0xcc "CALL Z,nn"
-        {24, &CPU::CALL},                  // 0xcd "CALL nn"
-        {8, &CPU::ADC_A_n},                // 0xce "ADC A,N"
-        {16, &CPU::RST},                   // 0xcf "RST 08h"
-
-        {8, &CPU::RET_cc},         // 0xd0 "RET NC"
-        {12, &CPU::pop_qq},        // 0xd1 "POP DE"
-        {12, &CPU::JP_cc_nn},      // 0xd2 "JP NC,NN"
-        {0, &CPU::invalid_opcode}, // 0xd3 "OUT (N),A"
-        {12, &CPU::CALL_cc_nn},    // 0xd4 "CALL NC,NN"
-        {16, &CPU::push_de},       // 0xd5 "PUSH DE"
-        {8, &CPU::SUB_n},          // 0xd6 "SUB N"
-        {16, &CPU::RST},           // 0xd7 "RST 10h"
-        {8, &CPU::RET_cc},         // 0xd8 "RET C"
-        {16, &CPU::RETI},          // 0xd9 "EXX"
-        {12, &CPU::JP_cc_nn},      // 0xda "JP C,NN"
-        {0, &CPU::invalid_opcode}, // 0xdb
-        {12, &CPU::CALL_cc_nn},    // 0xdc "CALL C,NN"
-        {0, &CPU::invalid_opcode}, // 0xdd
-        {8, &CPU::SBC_n},          // 0xde "SBC N"
-        {16, &CPU::RST},           // 0xdf "RST 18h"
-
-        {12, &CPU::LD_ff00n_A},    // 0xe0 LD_ff00 + n, A
-        {12, &CPU::pop_qq},        // 0xe1 "POP HL"
-        {8, &CPU::LD_ff00C_A},     // 0xe2 "JP PO,NN"
-        {0, &CPU::invalid_opcode}, // 0xe3 -
-        {0, &CPU::invalid_opcode}, // 0xe4 -
-        {16, &CPU::push_hl},       // 0xe5 "PUSH HL"
-        {8, &CPU::AND_n},          // 0xe6 "AND N"
-        {16, &CPU::RST},           // 0xe7 "RST 20h"
-        {16, &CPU::ADD_SP_s8},     // 0xe8 "RET PE"
-        {4, &CPU::JP_pHL},         // 0xe9 "JP (HL)"
-        {16, &CPU::LD_pnn_A},      // 0xea "LD (nn),A"
-        {0, &CPU::invalid_opcode}, // 0xeb
-        {0, &CPU::invalid_opcode}, // 0xec
-        {0, &CPU::invalid_opcode}, // 0xed
-        {8, &CPU::XOR_n},          // 0xee "XOR N"
-        {16, &CPU::RST},           // 0xef "RST 28h"
-
-        {12, &CPU::LD_A_ff00n},        // 0xf0 "RET P"
-        {12, &CPU::pop_qq},            // 0xf1 "POP AF"
-        {8, &CPU::LD_A_ff00C},         // 0xf2 "JP P,NN"
-        {4, &CPU::disable_interrupts}, // 0xf3 "DI"
-        {0, &CPU::invalid_opcode},     // 0xf4
-        {16, &CPU::push_af},           // 0xf5 "PUSH AF"
-        {8, &CPU::OR_n},               // 0xf6 "OR N"
-        {16, &CPU::RST},               // 0xf7 "RST 30h"
-        {12, &CPU::LD_HL_SPs8},        // 0xf8 "LD HL,SP+s8"
-        {8, &CPU::ld_sp_hl},           // 0xf9 "LD SP,HL"
-        {16, &CPU::LD_A_pnnnn},        // 0xfa "LD A,(nnnn)"
-        {4, &CPU::enable_interrupts},  // 0xfb "EI"
-        {0, &CPU::invalid_opcode},     // 0xfc
-        {0, &CPU::invalid_opcode},     // 0xfd
-        {8, &CPU::CP_n},               // 0xfe "CP N"
-        {16, &CPU::RST}                // 0xff "RST 38h"
-    };
 }
 
 // opcodes: 0xCB ..
 void CPU::decode_bit_instruction()
 {
     uint8_t op2 = fetch8BitValue(); // fetch next opcode
-    // Get the number of cycles that the bit instruction spent
-    additional_cycles_spent += do_bit_instruction(op2);
+    const Instruction &instruction = bit_opcode_table[op2];
+    (this->*instruction.code)();
+    // The 0xCB prefix itself is accounted for by the base opcode table
+    additional_cycles_spent += instruction.cycles - opcode_table[0xcb].cycles;
 }
 
 void CPU::reset()
@@ -338,6 +341,7 @@ void CPU::reset()
     // [$FF4B] = $00   ; WX
     // [$FFFF] = $00   ; IE
 
+    lazy_flags = LazyFlags::None;
     regs.AF = 0x1180;
     regs.BC = 0;
     regs.DE = 0xff56;
@@ -346,7 +350,14 @@ void CPU::reset()
 
     regs.PC = 0;
     mem.Write(IOAddress::Boot_ROM_Disabled, 0);
+    additional_cycles_spent = 0;
     is_halted = false;
+    // A new cartridge might have been loaded
+    block_cache.Clear();
+    idle_loop.Reset();
+#ifdef MEGABOY_JIT
+    jit.Reset();
+#endif
 }
 
 void CPU::AddDebugLog()
@@ -355,6 +366,39 @@ void CPU::AddDebugLog()
     // debug_log_entries.push_back(entry);
 }
 
+template <uint8_t opcode>
+inline uint8_t CPU::execute_opcode()
+{
+    constexpr Instruction instruction = opcode_table[opcode];
+    (this->*instruction.code)();
+    return instruction.cycles;
+}
+
+// One case per opcode, generated in blocks so all 256 are covered exactly once
+#define OPCODE_CASE(opcode) case (opcode): return execute_opcode<(opcode)>();
+#define OPCODE_CASES_4(base) OPCODE_CASE(base) OPCODE_CASE(base + 1) OPCODE_CASE(base + 2) OPCODE_CASE(base + 3)
+#define OPCODE_CASES_16(base) OPCODE_CASES_4(base) OPCODE_CASES_4(base + 4) OPCODE_CASES_4(base + 8) OPCODE_CASES_4(base + 12)
+#define OPCODE_CASES_64(base) OPCODE_CASES_16(base) OPCODE_CASES_16(base + 16) OPCODE_CASES_16(base + 32) OPCODE_CASES_16(base + 48)
+
+uint8_t CPU::execute(uint8_t opcode)
+{
+    // As every case refers to a constant entry in `opcode_table`,
+    // the compiler emits a jump table with direct (and inlinable) calls instead of calls through member function pointers.
+    switch (opcode)
+    {
+    OPCODE_CASES_64(0x00)
+    OPCODE_CASES_64(0x40)
+    OPCODE_CASES_64(0x80)
+    OPCODE_CASES_64(0xc0)
+    }
+    return 0; // unreachable, all 256 opcodes are handled above
+}
+
+#undef OPCODE_CASES_64
+#undef OPCODE_CASES_16
+#undef OPCODE_CASES_4
+#undef OPCODE_CASE
+
 uint8_t CPU::step()
 {
     uint8_t cycles_spent = 0;
@@ -363,16 +407,34 @@ uint8_t CPU::step()
     {
         // M1: OP Code fetch
         current_pc = regs.PC;
-        current_opcode = fetch8BitValue();
+        const DecodedInstruction *decoded = use_block_cache ? block_cache.Fetch(regs.PC) : nullptr;
+        if (decoded != nullptr)
+        {
+            current_opcode = decoded->opcode;
+            regs.PC++;
+            prefetched_operands = decoded->operands;
+        }
+        else
+        {
+            current_opcode = fetch8BitValue();
+        }
         // if(current_pc < 0x100){
         //     DumpDebugLog();
         //    exit(1);
         // }
 
-        (this->*instructions[current_opcode].code)();
-
         // Cycles spent in this step = base instruction cycles + additional cycles spent (i.e. jumps and conditions taking longer depending on outcome)
-        cycles_spent = this->instructions[current_opcode].cycles + additional_cycles_spent;
+        if (dispatch_mode == DispatchMode::Switch)
+        {
+            cycles_spent = execute(current_opcode) + additional_cycles_spent;
+        }
+        else
+        {
+            (this->*instructions[current_opcode].code)();
+            cycles_spent = this->instructions[current_opcode].cycles + additional_cycles_spent;
+        }
+
+        prefetched_operands = nullptr;
     }
     else
     {
@@ -390,15 +452,117 @@ uint8_t CPU::step()
         regs.PC = current_pc;
     }
 
+    // A jump back may have closed an idle loop, see Gameboy::Step
+    if (use_idle_loop_skipping && !is_halted)
+    {
+        idle_loop.OnStep(current_opcode, current_pc, regs.PC, cycles_spent);
+    }
+
     return cycles_spent;
 };
 
+uint32_t CPU::run_native_code(uint32_t budget)
+{
+    uint16_t pc = regs.PC;
+
+    // Only ROM code is run natively. Entering at the middle of a block happens after native code exited early, let the interpreter finish it.
+    if (!use_native_code || !use_block_cache || is_halted || pc >= 0x8000 || block_cache.IsInsideBlock(pc))
+    {
+        return 0;
+    }
+
+    DecodedBlock *block = block_cache.Enter(pc);
+    if (block == nullptr)
+    {
+        return 0;
+    }
+
+    if (block->native_code == nullptr)
+    {
+        if (block->native_code_unsupported)
+        {
+            return 0;
+        }
+        block->entries++;
+#ifdef MEGABOY_AOT
+        if (block->entries == 1 && aot.IsLoaded())
+        {
+            aot.Attach(*block, mem.GetCodeBank(pc), pc);
+        }
+#endif
+#ifdef MEGABOY_JIT
+        if (block->native_code == nullptr && block->entries >= jit.compile_threshold)
+        {
+            jit.Compile(*block, pc);
+        }
+#endif
+        if (block->native_code == nullptr)
+        {
+            return 0;
+        }
+    }
+
+    if (block->native_cycles > budget)
+    {
+        return 0;
+    }
+
+    // Native code reads and writes F directly
+    materialize_flags();
+    idle_loop.Leave();
+
+    auto native_block = reinterpret_cast<NativeBlock>(block->native_code);
+    return native_block(this, &regs, budget);
+}
+
 // *******************************************************
 // Flag helpers
 // *******************************************************
 
+void CPU::compute_lazy_flags()
+{
+    uint8_t result = lazy_result & 0xff;
+    uint8_t flags = result == 0 ? FlagBitmaskZero : 0;
+
+    switch (lazy_flags)
+    {
+    case LazyFlags::Add:
+        flags |= (lazy_operand_a & 0x0f) + (lazy_operand_b & 0x0f) + lazy_carry > 0x0f ? FlagBitmaskHalfCarry : 0;
+        flags |= lazy_result > 0xff ? FlagBitmaskC : 0;
+        break;
+    case LazyFlags::Sub:
+        flags |= FlagBitmaskN;
+        flags |= ((lazy_operand_a ^ lazy_operand_b ^ lazy_result) & 0x10) ? FlagBitmaskHalfCarry : 0;
+        flags |= (lazy_result & 0xff00) ? FlagBitmaskC : 0;
+        break;
+    case LazyFlags::And:
+        flags |= FlagBitmaskHalfCarry;
+        break;
+    case LazyFlags::Inc:
+        flags |= (result & 0x0f) == 0 ? FlagBitmaskHalfCarry : 0;
+        flags |= lazy_carry ? FlagBitmaskC : 0;
+        break;
+    case LazyFlags::Dec:
+        flags |= FlagBitmaskN;
+        flags |= (result & 0x0f) == 0x0f ? FlagBitmaskHalfCarry : 0;
+        flags |= lazy_carry ? FlagBitmaskC : 0;
+        break;
+    default:
+        break;
+    }
+
+    regs.F = (regs.F & 0x0f) | flags;
+    lazy_flags = LazyFlags::None;
+}
+
 void CPU::set_AND_operation_flags()
 {
+    if (use_lazy_flags)
+    {
+        lazy_result = regs.A;
+        lazy_flags = LazyFlags::And;
+        return;
+    }
 
     setFlag(FlagBitmaskZero, regs.A == 0);
     setFlag(FlagBitmaskN, 0);
@@ -408,6 +572,14 @@ void CPU::set_AND_operation_flags()
 
 void CPU::set_INC_operation_flags(uint8_t result)
 {
+    if (use_lazy_flags)
+    {
+        lazy_carry = carry_flag();
+        lazy_result = result;
+        lazy_flags = LazyFlags::Inc;
+        return;
+    }
+
     setFlag(FlagBitmaskZero, result == 0);               // Set if result is zero
     setFlag(FlagBitmaskHalfCarry, (result & 0x0f) == 0); // Set if carry over from bit 3
     setFlag(FlagBitmaskN, false);                        // reset
@@ -415,6 +587,14 @@ void CPU::set_INC_operation_flags(uint8_t result)
 
 void CPU::set_DEC_operation_flags(uint8_t result)
 {
+    if (use_lazy_flags)
+    {
+        lazy_carry = carry_flag();
+        lazy_result = result;
+        lazy_flags = LazyFlags::Dec;
+        return;
+    }
+
     setFlag(FlagBitmaskZero, result == 0); // Set if result is zero
     setFlag(FlagBitmaskHalfCarry, (result & 0xf) == 0xf);
     setFlag(FlagBitmaskN, true); // set
@@ -9,10 +9,18 @@ void CPU::add(uint8_t srcValue, bool carry)
 
     // Page 107 in z80 technical manual.
 
-    uint16_t result = regs.A + srcValue;
-    if (carry && (regs.F & FlagBitmaskC))
+    bool carry_in = carry && carry_flag();
+    uint16_t result = regs.A + srcValue + carry_in;
+
+    if (use_lazy_flags)
     {
-        result++;
+        lazy_operand_a = regs.A;
+        lazy_operand_b = srcValue;
+        lazy_carry = carry_in;
+        lazy_result = result;
+        lazy_flags = LazyFlags::Add;
+        regs.A = static_cast<uint8_t>(result);
+        return;
     }
 
     if (carry)
@@ -53,10 +61,24 @@ void CPU::sub(uint8_t srcValue, bool carry, bool onlySetFlagsForComparison)
 {
 
     uint16_t result = regs.A - srcValue;
-    if (carry && (regs.F & FlagBitmaskC))
+    if (carry && carry_flag())
     {
         result--;
     }
+
+    if (use_lazy_flags)
+    {
+        lazy_operand_a = regs.A;
+        lazy_operand_b = srcValue;
+        lazy_result = result;
+        lazy_flags = LazyFlags::Sub;
+        if (!onlySetFlagsForComparison)
+        {
+            regs.A = result & 0xff;
+        }
+        return;
+    }
+
     setFlag(FlagBitmaskZero, (result & 0xff) == 0);
     setFlag(FlagBitmaskN, true);
     setFlag(FlagBitmaskHalfCarry, ((regs.A ^ srcValue ^ result) & 0x10) != 0);
@@ -98,13 +120,6 @@ void CPU::DEC_r(uint8_t &reg)
 // Compare
 // *********************************************************************************
 
-void CPU::CP_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-    sub(srcRegValue, false, true);
-}
-
 // CP N
 // Compare A with N by internally doing a sub but only setting flags
 // opcode: 0xfe
@@ -155,17 +170,6 @@ void CPU::ADD_HL_SP()
     add16(regs.HL, regs.SP);
 }
 
-// ADD a,r
-// cycles: 4
-// flags: s z h pv n c
-void CPU::ADD_A_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-
-    add(srcRegValue, false);
-}
-
 // cycles: 7
 void CPU::ADD_A_n()
 {
@@ -173,14 +177,6 @@ void CPU::ADD_A_n()
     add(srcRegValue, false);
 }
 
-void CPU::ADC_A_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-
-    add(srcRegValue, true);
-}
-
 // ADC A,N
 // opcode: 0xce
 // cycles: 7
@@ -194,13 +190,6 @@ void CPU::ADC_A_n()
 // SUB
 // *********************************************************************************
 
-void CPU::SUB_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-    sub(srcRegValue, false, false);
-}
-
 // SUB N
 // opcode: 0xd6
 // cycles: 7
@@ -210,13 +199,6 @@ void CPU::SUB_n()
     sub(srcRegValue, false, false);
 }
 
-void CPU::SBC_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-    sub(srcRegValue, true, false);
-}
-
 // SBC N
 // opcode: 0xde
 // cycles: 7
@@ -236,14 +218,6 @@ void CPU::and_a_with_value(uint8_t value)
     set_AND_operation_flags();
 }
 
-// cycles: 4
-void CPU::AND_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-    and_a_with_value(srcRegValue);
-}
-
 void CPU::AND_n()
 {
     auto value = fetch8BitValue();
@@ -254,19 +228,6 @@ void CPU::AND_n()
 // XOR
 // *********************************************************************************
 
-// cycles:
-// xor r 4
-// xor n 7
-// xor (hl) 7
-// xor (IX+d) 19
-// xor (IY+d) 19
-void CPU::XOR_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-    xor_a_with_value(srcRegValue);
-}
-
 // opcode: 0xee
 // cycles: 7
 void CPU::XOR_n()
@@ -279,6 +240,13 @@ void CPU::xor_a_with_value(uint8_t value)
 {
     regs.A ^= value;
 
+    if (use_lazy_flags)
+    {
+        lazy_result = regs.A;
+        lazy_flags = LazyFlags::OrXor;
+        return;
+    }
+
     setFlag(FlagBitmaskZero, regs.A == 0);
     setFlag(FlagBitmaskHalfCarry, false);
     setFlag(FlagBitmaskN, false);
@@ -289,17 +257,6 @@ void CPU::xor_a_with_value(uint8_t value)
 // Or
 // *********************************************************************************
 
-// cycles:
-// or r 4
-// or n 7
-// or (hl) 7
-void CPU::OR_r()
-{
-    uint8_t srcRegCode = current_opcode & 0b111;
-    uint8_t srcRegValue = read_from_register(srcRegCode);
-    or_a_with_value(srcRegValue);
-}
-
 // OR N
 // opcode: 0xf6
 // cycles: 7
@@ -312,6 +269,13 @@ void CPU::or_a_with_value(uint8_t value)
 {
     regs.A |= value;
 
+    if (use_lazy_flags)
+    {
+        lazy_result = regs.A;
+        lazy_flags = LazyFlags::OrXor;
+        return;
+    }
+
     setFlag(FlagBitmaskZero, regs.A == 0);
     setFlag(FlagBitmaskHalfCarry, 0);
     setFlag(FlagBitmaskN, 0);
@@ -522,7 +486,7 @@ void CPU::ADD_SP_s8()
 {
     auto value = static_cast<int8_t>(fetch8BitValue());
     uint16_t result = regs.SP + value;
-    regs.F = 0;
+    write_F(0);
     setFlag(FlagBitmaskC, (regs.SP & 0x00FF) + (value & 0xff) > 0x00FF);
     setFlag(FlagBitmaskHalfCarry, (regs.SP & 0x000f) + (value & 0x000f) > 0x000f);
     regs.SP = result & 0xffff;
@@ -4,209 +4,198 @@
 
 #include "cpu.h"
 
-/// Perform a bit instruction from the "bit opcode group"
-/// \param op2 The opcode which contains the information about the operation
-/// \returns number of CPU cycles spent
+#include <utility>
 
-uint8_t CPU::do_bit_instruction(uint8_t op2)
-{
-    uint8_t reg_code = op2 & 0b00000111;
-    uint8_t invalue = read_from_register(reg_code);
-    uint8_t cycles_spend = 8;
-
-    // RLC r
-    // opcode: 0x00 - 0x07
-    // cycles: 8
-    if (op2 >= 0 && op2 <= 0x07)
-    {
-        uint8_t carry = invalue & 0x80;
-        invalue = invalue << 1;
-        invalue |= (carry ? 1 : 0);
-
-        setFlag(FlagBitmaskHalfCarry, false);
-        setFlag(FlagBitmaskN, false);
-        setFlag(FlagBitmaskC, carry);
-        setFlag(FlagBitmaskZero, invalue == 0);
-    }
-    else
-
-        // RRC r
-        // opcode: 0x08 - 0x0f
-        // cycles:
-        // RRC r : 8
-        // RRC (HL) : 15
-        if (op2 >= 0x08 && op2 <= 0xf)
-        {
-            bool carry = (invalue & 0x01) != 0;
-            invalue = invalue >> 1;
-
-            invalue |= (carry ? 0x80 : 0);
-
-            setFlag(FlagBitmaskHalfCarry, false);
-            setFlag(FlagBitmaskN, false);
-            setFlag(FlagBitmaskC, carry);
-            setFlag(FlagBitmaskZero, invalue == 0);
-        }
-        else
-
-            // RL r
-            // opcode: 0x10 - 0x17
-            // cycles:
-            // RL r: 8
-            // RL (hl): 15
-            // flags: Z H N C
-            if (op2 >= 0x10 && op2 <= 0x17)
-            {
-                uint8_t carry = invalue & 0x80;
-
-                invalue = invalue << 1;
-                invalue |= (regs.F & FlagBitmaskC) ? 1 : 0;
-
-                setFlag(FlagBitmaskHalfCarry, false);
-                setFlag(FlagBitmaskN, false);
-                setFlag(FlagBitmaskC, carry);
-                setFlag(FlagBitmaskZero, invalue == 0);
-            }
-            else
-
-                // RR r
-                // opcode: 0x18 - 0x1f
-                // cycles:
-                // RR r: 8
-                // RR (hl): 15
-                // flags: Z H N C
-                if ((op2 & 0b11111000) == 0b00011000)
-                {
-                    uint8_t carry = invalue & 0x01;
+// *********************************************************************************
+// CB-prefixed bit instructions
+// *********************************************************************************
 
-                    invalue = invalue >> 1;
-                    invalue |= (regs.F & FlagBitmaskC) ? 0x80 : 0;
-
-                    setFlag(FlagBitmaskHalfCarry, false);
-                    setFlag(FlagBitmaskN, false);
-                    setFlag(FlagBitmaskC, carry);
-                    setFlag(FlagBitmaskZero, invalue == 0);
-                }
-                else
-
-                    // SLA r
-                    // opcode: 0x20 - 0x27
-                    // cycles: r:8 (hl):15
-                    if (op2 >= 0x20 && op2 <= 0x27)
-                    {
-                        uint8_t carry = invalue & 0x80;
-
-                        invalue = invalue << 1;
-
-                        setFlag(FlagBitmaskHalfCarry, false);
-                        setFlag(FlagBitmaskN, false);
-                        setFlag(FlagBitmaskC, carry);
-                        setFlag(FlagBitmaskZero, invalue == 0);
-                    }
-                    else
+/// Flags shared by all rotate and shift instructions of the bit opcode group.
+/// flags: Z N H C
+void CPU::set_rotate_shift_flags(uint8_t result, bool carry)
+{
+    setFlag(FlagBitmaskHalfCarry, false);
+    setFlag(FlagBitmaskN, false);
+    setFlag(FlagBitmaskC, carry);
+    setFlag(FlagBitmaskZero, result == 0);
+}
 
-                        // SRA r
-                        // opcode: 0x28 - 0x2f
-                        // cycles: r:8 (hl):15 (ix+d):23
-                        if (op2 >= 0x28 && op2 <= 0x2f)
-                        {
-                            uint8_t carry = invalue & 0x01;
-                            int8_t signedValue = invalue;
-                            // TODO: page 210. Make sure this is an arithmetic shift that preserves bit 7
-                            signedValue = signedValue >> 1;
-                            invalue = signedValue;
+// RLC r
+// opcode: 0x00 - 0x07
+template <RegisterCode reg>
+void CPU::RLC_r()
+{
+    uint8_t value = read_register<reg>();
+    bool carry = value & 0x80;
+    value = (value << 1) | (carry ? 1 : 0);
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, carry);
+}
 
-                            setFlag(FlagBitmaskHalfCarry, false);
-                            setFlag(FlagBitmaskN, false);
-                            setFlag(FlagBitmaskC, carry);
-                            setFlag(FlagBitmaskZero, invalue == 0);
-                        }
-                        else
+// RRC r
+// opcode: 0x08 - 0x0f
+template <RegisterCode reg>
+void CPU::RRC_r()
+{
+    uint8_t value = read_register<reg>();
+    bool carry = value & 0x01;
+    value = (value >> 1) | (carry ? 0x80 : 0);
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, carry);
+}
 
-                            // SWAP r
-                            // opcode: 0xCB 0x30-0x37
-                            // SWAP r
-                            // swap low/hi-nibble
+// RL r - rotate left through carry
+// opcode: 0x10 - 0x17
+template <RegisterCode reg>
+void CPU::RL_r()
+{
+    uint8_t value = read_register<reg>();
+    bool carry = value & 0x80;
+    value = (value << 1) | (getFlag(FlagBitmaskC) ? 1 : 0);
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, carry);
+}
 
-                            if (op2 >= 0x30 && op2 <= 0x37)
-                            {
+// RR r - rotate right through carry
+// opcode: 0x18 - 0x1f
+template <RegisterCode reg>
+void CPU::RR_r()
+{
+    uint8_t value = read_register<reg>();
+    bool carry = value & 0x01;
+    value = (value >> 1) | (getFlag(FlagBitmaskC) ? 0x80 : 0);
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, carry);
+}
 
-                                uint8_t temp = (invalue & 0xf) << 4;
-                                invalue >>= 4;
-                                invalue |= temp;
-                                regs.F = 0;
-                                setFlag(FlagBitmaskZero, invalue == 0);
-                            }
-                            else
+// SLA r - shift left arithmetic
+// opcode: 0x20 - 0x27
+template <RegisterCode reg>
+void CPU::SLA_r()
+{
+    uint8_t value = read_register<reg>();
+    bool carry = value & 0x80;
+    value <<= 1;
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, carry);
+}
 
-                                // SRL r
-                                // Shift right
-                                // cycles: 8
-                                if (op2 >= 0x38 && op2 <= 0x3f)
-                                {
-                                    uint8_t carry = invalue & 0x01;
+// SRA r - shift right arithmetic, bit 7 is preserved
+// opcode: 0x28 - 0x2f
+template <RegisterCode reg>
+void CPU::SRA_r()
+{
+    uint8_t value = read_register<reg>();
+    bool carry = value & 0x01;
+    value = (value >> 1) | (value & 0x80);
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, carry);
+}
 
-                                    invalue = invalue >> 1;
+// SWAP r - swap low/hi-nibble
+// opcode: 0x30 - 0x37
+template <RegisterCode reg>
+void CPU::SWAP_r()
+{
+    uint8_t value = read_register<reg>();
+    value = (value << 4) | (value >> 4);
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, false);
+}
 
-                                    setFlag(FlagBitmaskHalfCarry, false);
-                                    setFlag(FlagBitmaskN, false);
-                                    setFlag(FlagBitmaskC, carry);
-                                    setFlag(FlagBitmaskZero, invalue == 0);
-                                }
-                                else
+// SRL r - shift right logical
+// opcode: 0x38 - 0x3f
+template <RegisterCode reg>
+void CPU::SRL_r()
+{
+    uint8_t value = read_register<reg>();
+    bool carry = value & 0x01;
+    value >>= 1;
+    write_register<reg>(value);
+    set_rotate_shift_flags(value, carry);
+}
 
-                                    // BIT b,r
-                                    // Test bit b in register r and sets Z flag accordingly
-                                    // opcode: 0x40 - 0x7f
-                                    // cycles: 8
-                                    // flag: Z H N
-                                    if (op2 >= 0x40 && op2 <= 0x7f)
-                                    {
-                                        uint8_t bitNumber = (op2 & 0b00111000) >> 3;
-                                        uint8_t result = invalue & (1 << bitNumber);
-                                        setFlag(FlagBitmaskZero, result == 0);
-                                        setFlag(FlagBitmaskHalfCarry, true);
-                                        setFlag(FlagBitmaskN, false);
-                                    }
-                                    else
+// BIT b,r
+// Test bit b in register r and sets Z flag accordingly
+// opcode: 0x40 - 0x7f (01 bbb rrr)
+// flags: Z H N
+template <uint8_t bit, RegisterCode reg>
+void CPU::BIT_b_r()
+{
+    setFlag(FlagBitmaskZero, (read_register<reg>() & (1 << bit)) == 0);
+    setFlag(FlagBitmaskHalfCarry, true);
+    setFlag(FlagBitmaskN, false);
+}
 
-                                        // RES b,r
-                                        // Reset bit b in register r
-                                        // opcode: 0x80 - 0xbf (01 bbb rrr)
-                                        // flags: -
-                                        // cycles: 8
-                                        if (op2 >= 0x80 && op2 <= 0xbf)
-                                        {
-                                            uint8_t bitNumber = (op2 & 0b00111000) >> 3;
-                                            uint8_t bitMask = ~(1 << bitNumber);
-                                            invalue &= bitMask;
-                                        }
-                                        else
+// RES b,r
+// Reset bit b in register r
+// opcode: 0x80 - 0xbf (10 bbb rrr)
+// flags: -
+template <uint8_t bit, RegisterCode reg>
+void CPU::RES_b_r()
+{
+    write_register<reg>(read_register<reg>() & ~(1 << bit));
+}
 
-                                            // SET b,r
-                                            // Set bit b in register r
-                                            // opcode: 0xc0 - 0xff (01 bbb rrr)
-                                            // flags: -
-                                            // cycles: 8
-                                            if (op2 >= 0xc0 && op2 <= 0xff)
-                                            {
-                                                uint8_t bitNumber = (op2 & 0b00111000) >> 3;
-                                                uint8_t bitMask = (1 << bitNumber);
-                                                invalue |= bitMask;
-                                            }
+// SET b,r
+// Set bit b in register r
+// opcode: 0xc0 - 0xff (11 bbb rrr)
+// flags: -
+template <uint8_t bit, RegisterCode reg>
+void CPU::SET_b_r()
+{
+    write_register<reg>(read_register<reg>() | (1 << bit));
+}
 
-    write_to_register(reg_code, invalue);
+/// Decode a CB-prefixed opcode into its handler and total cycles.
+/// cycles: 8 for registers, 16 for (HL), except BIT b,(HL) which only reads memory and takes 12
+template <uint8_t op2>
+constexpr CPU::Instruction CPU::bit_instruction()
+{
+    constexpr auto reg = static_cast<RegisterCode>(op2 & 0b111);
+    constexpr uint8_t bit = (op2 >> 3) & 0b111;
+    constexpr uint8_t operation = op2 >> 6;
+    constexpr uint8_t cycles = reg != HLPtr ? 8 : (operation == 0b01 ? 12 : 16);
+
+    if constexpr (operation == 0b01)
+        return {cycles, &CPU::BIT_b_r<bit, reg>};
+    else if constexpr (operation == 0b10)
+        return {cycles, &CPU::RES_b_r<bit, reg>};
+    else if constexpr (operation == 0b11)
+        return {cycles, &CPU::SET_b_r<bit, reg>};
+    else if constexpr (bit == 0)
+        return {cycles, &CPU::RLC_r<reg>};
+    else if constexpr (bit == 1)
+        return {cycles, &CPU::RRC_r<reg>};
+    else if constexpr (bit == 2)
+        return {cycles, &CPU::RL_r<reg>};
+    else if constexpr (bit == 3)
+        return {cycles, &CPU::RR_r<reg>};
+    else if constexpr (bit == 4)
+        return {cycles, &CPU::SLA_r<reg>};
+    else if constexpr (bit == 5)
+        return {cycles, &CPU::SRA_r<reg>};
+    else if constexpr (bit == 6)
+        return {cycles, &CPU::SWAP_r<reg>};
+    else
+        return {cycles, &CPU::SRL_r<reg>};
+}
 
-    return cycles_spend;
+template <std::size_t... op2>
+static constexpr std::array<CPU::Instruction, 256> make_bit_opcode_table(std::index_sequence<op2...>)
+{
+    return {{CPU::bit_instruction<op2>()...}};
 }
 
+constexpr std::array<CPU::Instruction, 256> CPU::bit_opcode_table = make_bit_opcode_table(std::make_index_sequence<256>{});
+
 /// RLCA
 /// opcode: 0x07
 /// cycles: 4
 void CPU::RLCA()
 {
     bool carry = regs.A & 0b10000000;
-    regs.F = 0;
+    write_F(0);
     setFlag(FlagBitmaskC, carry);
     setFlag(FlagBitmaskHalfCarry, false);
     setFlag(FlagBitmaskN, false);
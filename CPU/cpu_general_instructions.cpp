@@ -41,7 +41,7 @@ void CPU::halt()
     }
     else
     {
-        if ((mem.Read(IOAddress::InterruptEnabled) & mem.Read(IOAddress::InterruptFlag) & 0b11111) == 0)
+        if (mem.interrupts.Pending() == 0)
         {
             // HALT mode is entered. It works like the IME = 1 case, but when a IF flag is set and
             // the corresponding IE flag is also set, the CPU doesn't jump to the interrupt vector, it
@@ -152,5 +152,5 @@ void CPU::ccf()
 {
     setFlag(FlagBitmaskHalfCarry, 0);
     setFlag(FlagBitmaskN, 0);
-    setFlag(FlagBitmaskC, !(regs.F & FlagBitmaskC));
+    setFlag(FlagBitmaskC, !getFlag(FlagBitmaskC));
 }
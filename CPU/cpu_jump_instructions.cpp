@@ -21,7 +21,7 @@ void CPU::JP_cc_nn()
 void CPU::JR_nc()
 {
     int8_t offset = static_cast<int8_t>(fetch8BitValue());
-    if (!(regs.F & FlagBitmaskC))
+    if (!getFlag(FlagBitmaskC))
     {
         regs.PC += offset;
     }
@@ -33,7 +33,7 @@ void CPU::JR_nc()
 void CPU::JR_c()
 {
     int8_t offset = static_cast<int8_t>(fetch8BitValue());
-    if ((regs.F & FlagBitmaskC))
+    if (getFlag(FlagBitmaskC))
     {
         regs.PC += offset;
     }
@@ -46,7 +46,7 @@ void CPU::JR_c()
 void CPU::JR_z()
 {
     int8_t offset = static_cast<int8_t>(fetch8BitValue());
-    if ((regs.F & FlagBitmaskZero))
+    if (getFlag(FlagBitmaskZero))
     {
         regs.PC += offset;
     }
@@ -58,7 +58,7 @@ void CPU::JR_z()
 void CPU::JR_nz()
 {
     int8_t offset = static_cast<int8_t>(fetch8BitValue());
-    if (!(regs.F & FlagBitmaskZero))
+    if (!getFlag(FlagBitmaskZero))
     {                      // If not zero
         regs.PC += offset; // start calculation from beginning of this instruction
     }
@@ -152,16 +152,16 @@ void CPU::RET_cc()
     switch (conditionCode)
     {
     case 0:
-        conditionValue = !(regs.F & FlagBitmaskZero);
+        conditionValue = !getFlag(FlagBitmaskZero);
         break; // Non zero
     case 1:
-        conditionValue = (regs.F & FlagBitmaskZero);
+        conditionValue = getFlag(FlagBitmaskZero);
         break; // zero
     case 2:
-        conditionValue = !(regs.F & FlagBitmaskC);
+        conditionValue = !getFlag(FlagBitmaskC);
         break; // non carry
     case 3:
-        conditionValue = (regs.F & FlagBitmaskC);
+        conditionValue = getFlag(FlagBitmaskC);
         break; // carry
     default:
         break;
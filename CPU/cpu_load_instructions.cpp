@@ -15,29 +15,6 @@ void CPU::LD_pnn_SP()
     mem.Write(addr + 1, regs.SPH);
 }
 
-void CPU::LD_r_r()
-{
-    uint8_t dstRegCode = (current_opcode >> 3) & 0b111;
-    uint8_t srcRegCode = current_opcode & 0b111;
-
-    uint8_t src_value = read_from_register(srcRegCode);
-
-    write_to_register(dstRegCode, src_value);
-
-    if (dstRegCode == 0 && srcRegCode == 0)
-    {
-        // LD B,B - mooneye test has completed
-        if (regs.B == 3)
-        {
-            std::cout << "Test OK!" << std::flush;
-        }
-        else
-        {
-            std::cout << "Test FAILED" << std::flush;
-        }
-    }
-}
-
 void CPU::LD_r_n()
 {
     uint8_t dstRegCode = (current_opcode >> 3) & 0b111;
@@ -220,7 +197,7 @@ void CPU::LD_HL_SPs8()
     auto value = static_cast<int8_t>(fetch8BitValue());
 
     regs.HL = regs.SP + value;
-    regs.F = 0;
+    write_F(0);
     setFlag(FlagBitmaskC, (regs.SP & 0xFF) + (value & 0xff) > 0xFF);
     setFlag(FlagBitmaskHalfCarry, (regs.SP & 0xf) + (value & 0xf) > 0xf);
 }
@@ -264,7 +241,7 @@ void CPU::pop_qq()
         break;
     case 3:
         pop16(regs.AF);
-        regs.F &= 0xf0; // Always mask out lower nibble of flags, as they are forced zero on hardware
+        write_F(regs.F & 0xf0); // Always mask out lower nibble of flags, as they are forced zero on hardware
         break;
     }
 }
@@ -297,6 +274,7 @@ void CPU::push_hl()
 /// cycles: 11
 void CPU::push_af()
 {
+    materialize_flags();
     mem.Write(--regs.SP, regs.A);
     mem.Write(--regs.SP, regs.F & 0xf0); // mask out the lower 4 bits to force them to always be zero
 }
@@ -0,0 +1,96 @@
+#include "idle_loop.h"
+
+void IdleLoopDetector::Reset()
+{
+    active = false;
+    armed = false;
+    has_last = false;
+}
+
+void IdleLoopDetector::OnJumpBack(uint16_t branch_pc, uint16_t target)
+{
+    uint16_t bank = mem.GetCodeBank(branch_pc);
+    if (!has_last || bank != last_bank || branch_pc != last_branch_pc || target != last_target)
+    {
+        last_bank = bank;
+        last_branch_pc = branch_pc;
+        last_target = target;
+        last_is_idle = IsIdleBody(target, branch_pc);
+        has_last = true;
+
+        if (last_is_idle)
+        {
+            detected_loops++;
+        }
+    }
+
+    if (!last_is_idle)
+    {
+        armed = false;
+        return;
+    }
+
+    // The first jump back may close a pass entered halfway. Only the next one is known to close a whole pass.
+    active = armed && loop_pc == target && loop_branch_pc == branch_pc;
+    if (active)
+    {
+        iteration_cycles = pass_cycles;
+    }
+    armed = true;
+    loop_pc = target;
+    loop_branch_pc = branch_pc;
+    pass_cycles = 0;
+}
+
+bool IdleLoopDetector::IsIdleBody(uint16_t target, uint16_t branch_pc) const
+{
+    uint16_t pc = target;
+
+    while (pc < branch_pc)
+    {
+        uint8_t opcode = mem.Read(pc);
+        uint8_t length = 1;
+
+        switch (opcode)
+        {
+        case 0x00: // NOP
+        case 0x0a: // LD A,(BC)
+        case 0x1a: // LD A,(DE)
+        case 0x7e: // LD A,(HL)
+        case 0xf2: // LD A,(C)
+            break;
+        case 0xf0: // LDH A,(n)
+        case 0xe6: // AND n
+        case 0xf6: // OR n
+        case 0xfe: // CP n
+            length = 2;
+            break;
+        case 0xfa: // LD A,(nn)
+            length = 3;
+            break;
+        case 0xcb:
+        {
+            // BIT b,r only sets flags
+            uint8_t op2 = mem.Read(pc + 1);
+            if (op2 < 0x40 || op2 > 0x7f)
+            {
+                return false;
+            }
+            length = 2;
+            break;
+        }
+        default:
+            // AND r, OR r and CP r. Registers other than A and F are never written in the loop, so they read the same on every pass.
+            if (opcode < 0xa0 || opcode > 0xbf || (opcode >= 0xa8 && opcode <= 0xaf))
+            {
+                return false;
+            }
+            break;
+        }
+
+        pc += length;
+    }
+
+    // The last instruction decoded must end right at the jump
+    return pc == branch_pc;
+}
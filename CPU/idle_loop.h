@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../HostMemory.h"
+
+/// Finds idle loops: short loops polling memory until something outside the CPU changes it, like
+///
+///     wait: LDH A,($44)
+///           CP $90
+///           JR NZ,wait
+///
+/// Every pass through such a loop reads the same values and leaves the CPU in the same state until a peripheral changes what is read
+/// or an interrupt is dispatched, so `Gameboy::Step` can skip whole passes up to the next peripheral event instead of executing them.
+///
+/// A loop is idle if it is in ROM, ends with a jump back to its first instruction, and only loads A from memory and tests it with
+/// AND, OR, CP and BIT. Loads and tests can only overwrite A and F with the same values on every pass, so nothing needs to be executed.
+class IdleLoopDetector
+{
+public:
+    /// The longest loop looked at, in bytes including the jump
+    static constexpr uint8_t MaxLoopLength = 16;
+
+    explicit IdleLoopDetector(HostMemory &mem) : mem(mem)
+    {
+    }
+
+    /// Set by `CPU::step` when the instruction it executed was a jump back to the start of an idle loop, closing a whole pass through it.
+    /// The CPU is then at `loop_pc`, in the state every further pass would leave it in.
+    bool active = false;
+    /// First instruction of the idle loop
+    uint16_t loop_pc = 0;
+    /// Cycles of one pass through the loop, including the jump back
+    uint16_t iteration_cycles = 0;
+
+    /// Number of times an idle loop was found
+    uint64_t detected_loops = 0;
+    uint64_t skipped_iterations = 0;
+    uint64_t skipped_cycles = 0;
+
+    /// Called by `CPU::step` after every instruction.
+    /// \param opcode the instruction executed at `pc`
+    /// \param next_pc where execution continues
+    /// \param cycles cycles the instruction took
+    inline void OnStep(uint8_t opcode, uint16_t pc, uint16_t next_pc, uint16_t cycles)
+    {
+        active = false;
+
+        // A pass entered halfway (by a jump into the loop or returning from an interrupt) may not leave A and F like a whole one
+        if (armed && (pc < loop_pc || pc > loop_branch_pc))
+        {
+            armed = false;
+        }
+        pass_cycles += cycles;
+
+        if (next_pc < pc && IsJump(opcode) && pc - next_pc < MaxLoopLength && pc < 0x8000)
+        {
+            OnJumpBack(pc, next_pc);
+        }
+    }
+
+    /// Forget the loop being executed, when code runs without `OnStep` seeing it
+    inline void Leave()
+    {
+        active = false;
+        armed = false;
+    }
+
+    void Reset();
+
+private:
+    HostMemory &mem;
+
+    /// Set when a jump closed the loop at `loop_pc` - `loop_branch_pc`, and execution stayed inside the loop since
+    bool armed = false;
+    uint16_t loop_branch_pc = 0;
+    /// Cycles since the loop was last closed
+    uint16_t pass_cycles = 0;
+
+    /// The loop checked last, so spinning in one doesn't decode it on every pass
+    uint16_t last_bank = 0;
+    uint16_t last_branch_pc = 0;
+    uint16_t last_target = 0;
+    bool last_is_idle = false;
+    bool has_last = false;
+
+    /// JR, JR cc, JP nn and JP cc,nn
+    static inline bool IsJump(uint8_t opcode)
+    {
+        switch (opcode)
+        {
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+        case 0xc2: case 0xc3: case 0xca: case 0xd2: case 0xda:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void OnJumpBack(uint16_t branch_pc, uint16_t target);
+
+    /// Decode the instructions from `target` up to `branch_pc`.
+    /// \returns whether they are all loads into A or tests of A
+    bool IsIdleBody(uint16_t target, uint16_t branch_pc) const;
+};
@@ -0,0 +1,487 @@
+#ifdef MEGABOY_JIT
+
+#include <cstring>
+#include <sys/mman.h>
+#include "jit_x64.h"
+#include "cpu.h"
+
+// *********************************************************************************
+// x86-64 code emitter
+// *********************************************************************************
+
+/// Maps the flags stored by LAHF (SF ZF - AF - PF - CF) to the SM83 Z, H and C flags
+static constexpr std::array<uint8_t, 256> make_lahf_to_flags()
+{
+    std::array<uint8_t, 256> flags{};
+    for (int ah = 0; ah < 256; ah++)
+    {
+        flags[ah] = ((ah & 0x40) ? FlagBitmaskZero : 0) | ((ah & 0x10) ? FlagBitmaskHalfCarry : 0) | ((ah & 0x01) ? FlagBitmaskC : 0);
+    }
+    return flags;
+}
+
+static constexpr std::array<uint8_t, 256> lahf_to_flags = make_lahf_to_flags();
+
+/// Byte offsets of the registers in CPU::GeneralRegisters
+static constexpr uint8_t OffsetA = offsetof(CPU::GeneralRegisters, A);
+static constexpr uint8_t OffsetF = offsetof(CPU::GeneralRegisters, F);
+static constexpr uint8_t OffsetSP = offsetof(CPU::GeneralRegisters, SP);
+static constexpr uint8_t OffsetPC = offsetof(CPU::GeneralRegisters, PC);
+
+/// Offset of an 8 bit register selected by a RegisterCode (not HLPtr)
+static uint8_t RegisterOffset(uint8_t register_code)
+{
+    switch (register_code)
+    {
+    case RegisterCode::B:
+        return offsetof(CPU::GeneralRegisters, B);
+    case RegisterCode::C:
+        return offsetof(CPU::GeneralRegisters, C);
+    case RegisterCode::D:
+        return offsetof(CPU::GeneralRegisters, D);
+    case RegisterCode::E:
+        return offsetof(CPU::GeneralRegisters, E);
+    case RegisterCode::H:
+        return offsetof(CPU::GeneralRegisters, H);
+    case RegisterCode::L:
+        return offsetof(CPU::GeneralRegisters, L);
+    default:
+        return OffsetA;
+    }
+}
+
+/// Offset of a 16 bit register pair encoded in bits 4-5 of an opcode (BC, DE, HL, SP)
+static uint8_t RegisterPairOffset(uint8_t opcode)
+{
+    static constexpr uint8_t offsets[] = {offsetof(CPU::GeneralRegisters, BC), offsetof(CPU::GeneralRegisters, DE),
+                                          offsetof(CPU::GeneralRegisters, HL), offsetof(CPU::GeneralRegisters, SP)};
+    return offsets[(opcode >> 4) & 0b11];
+}
+
+/// Emits the machine code of a single block.
+/// Register usage in the generated code:
+/// rbx = CPU::GeneralRegisters, r14 = CPU, r12d = cycle budget, r13d = cycles spent, r15 = lahf_to_flags
+class X64Emitter
+{
+public:
+    std::vector<uint8_t> code;
+
+    void Bytes(std::initializer_list<uint8_t> bytes)
+    {
+        code.insert(code.end(), bytes);
+    }
+
+    void Imm16(uint16_t value)
+    {
+        Bytes({static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)});
+    }
+
+    void Imm32(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void Imm64(uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void Prologue()
+    {
+        Bytes({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57}); // push rbx, r12, r13, r14, r15
+        Bytes({0x49, 0x89, 0xfe});                                     // mov r14, rdi
+        Bytes({0x48, 0x89, 0xf3});                                     // mov rbx, rsi
+        Bytes({0x41, 0x89, 0xd4});                                     // mov r12d, edx
+        Bytes({0x45, 0x31, 0xed});                                     // xor r13d, r13d
+        Bytes({0x49, 0xbf});                                           // mov r15, lahf_to_flags
+        Imm64(reinterpret_cast<uint64_t>(lahf_to_flags.data()));
+    }
+
+    /// Return the cycles spent
+    void Epilogue()
+    {
+        Bytes({0x44, 0x89, 0xe8});                                     // mov eax, r13d
+        Bytes({0x41, 0x5f, 0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c, 0x5b}); // pop r15, r14, r13, r12, rbx
+        Bytes({0xc3});                                                 // ret
+    }
+
+    void ExitWithPC(uint16_t pc)
+    {
+        Bytes({0x66, 0xc7, 0x43, OffsetPC}); // mov word [rbx+PC], pc
+        Imm16(pc);
+        Epilogue();
+    }
+
+    void AddCycles(uint8_t cycles)
+    {
+        Bytes({0x41, 0x83, 0xc5, cycles}); // add r13d, cycles
+    }
+
+    /// Jump back to `target` if another `cycles` fit in the budget
+    void LoopIfWithinBudget(size_t target, uint16_t cycles)
+    {
+        Bytes({0x41, 0x8d, 0x85}); // lea eax, [r13 + cycles]
+        Imm32(cycles);
+        Bytes({0x44, 0x39, 0xe0}); // cmp eax, r12d
+        Bytes({0x0f, 0x86});       // jbe target
+        Imm32(static_cast<uint32_t>(target - (code.size() + 4)));
+    }
+
+    /// Emit a conditional jump with a 32 bit displacement to be patched later
+    /// \returns the position of the displacement
+    size_t JumpIf(uint8_t condition_opcode)
+    {
+        Bytes({0x0f, condition_opcode});
+        size_t position = code.size();
+        Imm32(0);
+        return position;
+    }
+
+    void PatchJumpToHere(size_t position)
+    {
+        uint32_t displacement = static_cast<uint32_t>(code.size() - (position + 4));
+        std::memcpy(&code[position], &displacement, 4);
+    }
+
+    /// Compose the SM83 flags from LAHF. Flags in `keep_mask` are kept from the old F, `set_mask` is or'ed in.
+    void StoreFlagsFromLahf(uint8_t lahf_mask, uint8_t keep_mask, uint8_t set_mask)
+    {
+        Bytes({0x9f});                         // lahf
+        Bytes({0x0f, 0xb6, 0xcc});             // movzx ecx, ah
+        Bytes({0x41, 0x8a, 0x0c, 0x0f});       // mov cl, [r15 + rcx]
+        Bytes({0x80, 0xe1, lahf_mask});        // and cl, lahf_mask
+        StoreFlagsFromCL(keep_mask, set_mask);
+    }
+
+    void StoreFlagsFromCL(uint8_t keep_mask, uint8_t set_mask)
+    {
+        Bytes({0x0f, 0xb6, 0x53, OffsetF}); // movzx edx, byte [rbx+F]
+        Bytes({0x80, 0xe2, keep_mask});     // and dl, keep_mask
+        Bytes({0x08, 0xca});                // or dl, cl
+        if (set_mask)
+        {
+            Bytes({0x80, 0xca, set_mask}); // or dl, set_mask
+        }
+        Bytes({0x88, 0x53, OffsetF}); // mov [rbx+F], dl
+    }
+
+    void CallInterpreter(uint32_t encoded, uint16_t pc)
+    {
+        Bytes({0x4c, 0x89, 0xf7}); // mov rdi, r14
+        Bytes({0xbe});             // mov esi, encoded
+        Imm32(encoded);
+        Bytes({0xba}); // mov edx, pc
+        Imm32(pc);
+        Bytes({0x48, 0xb8}); // mov rax, InterpretInstruction
+        Imm64(reinterpret_cast<uint64_t>(&InterpretInstruction));
+        Bytes({0xff, 0xd0}); // call rax
+    }
+};
+
+/// ALU operations in bits 3-5 of ALU A,r (0x80-0xbf) and ALU A,n (0xc6-0xfe)
+enum AluOperation : uint8_t
+{
+    AluADD = 0,
+    AluADC,
+    AluSUB,
+    AluSBC,
+    AluAND,
+    AluXOR,
+    AluOR,
+    AluCP
+};
+
+/// Emit an 8 bit ALU operation on A with either a register (`src_offset`) or an immediate value
+static void EmitAlu(X64Emitter &x, uint8_t operation, bool immediate, uint8_t value)
+{
+    // x86 "op al, cl" and "op al, imm8" opcodes for each AluOperation
+    static constexpr uint8_t register_opcodes[] = {0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38};
+    static constexpr uint8_t immediate_opcodes[] = {0x04, 0x14, 0x2c, 0x1c, 0x24, 0x34, 0x0c, 0x3c};
+
+    x.Bytes({0x8a, 0x43, OffsetA}); // mov al, [rbx+A]
+    if (!immediate)
+    {
+        x.Bytes({0x8a, 0x4b, value}); // mov cl, [rbx+src]
+    }
+
+    if (operation == AluADC || operation == AluSBC)
+    {
+        x.Bytes({0x0f, 0xb6, 0x53, OffsetF}); // movzx edx, byte [rbx+F]
+        x.Bytes({0x0f, 0xba, 0xe2, 0x04});    // bt edx, 4 (carry flag into CF)
+    }
+
+    if (immediate)
+    {
+        x.Bytes({immediate_opcodes[operation], value}); // op al, imm8
+    }
+    else
+    {
+        x.Bytes({register_opcodes[operation], 0xc8}); // op al, cl
+    }
+
+    if (operation != AluCP)
+    {
+        x.Bytes({0x88, 0x43, OffsetA}); // mov [rbx+A], al
+    }
+
+    switch (operation)
+    {
+    case AluADD:
+    case AluADC:
+        x.StoreFlagsFromLahf(0xff, 0x0f, 0);
+        break;
+    case AluSUB:
+    case AluSBC:
+    case AluCP:
+        x.StoreFlagsFromLahf(0xff, 0x0f, FlagBitmaskN);
+        break;
+    default:
+        // AND, XOR and OR: Z from the result, H set for AND, N and C cleared
+        x.Bytes({0x0f, 0x94, 0xc1}); // sete cl
+        x.Bytes({0xc0, 0xe1, 0x07}); // shl cl, 7
+        x.StoreFlagsFromCL(0x0f, operation == AluAND ? FlagBitmaskHalfCarry : 0);
+        break;
+    }
+}
+
+/// Emit a native instruction. Control flow instructions are handled by the caller.
+static void EmitNative(X64Emitter &x, const DecodedInstruction &instruction)
+{
+    uint8_t opcode = instruction.opcode;
+    uint8_t dst = (opcode >> 3) & 0b111;
+    uint8_t src = opcode & 0b111;
+
+    switch (opcode)
+    {
+    case 0x00: // NOP
+        return;
+    case 0x01:
+    case 0x11:
+    case 0x21:
+    case 0x31: // LD rr,nn
+        x.Bytes({0x66, 0xc7, 0x43, RegisterPairOffset(opcode)});
+        x.Imm16(instruction.operands[0] | (instruction.operands[1] << 8));
+        return;
+    case 0x03:
+    case 0x13:
+    case 0x23:
+    case 0x33: // INC rr
+        x.Bytes({0x66, 0xff, 0x43, RegisterPairOffset(opcode)});
+        return;
+    case 0x0b:
+    case 0x1b:
+    case 0x2b:
+    case 0x3b: // DEC rr
+        x.Bytes({0x66, 0xff, 0x4b, RegisterPairOffset(opcode)});
+        return;
+    case 0x2f:                               // CPL
+        x.Bytes({0xf6, 0x53, OffsetA});       // not byte [rbx+A]
+        x.Bytes({0x80, 0x4b, OffsetF, 0x60}); // or byte [rbx+F], N|H
+        return;
+    case 0x37:                               // SCF
+        x.Bytes({0x80, 0x63, OffsetF, 0x8f}); // and byte [rbx+F], ~(N|H|C)
+        x.Bytes({0x80, 0x4b, OffsetF, 0x10}); // or byte [rbx+F], C
+        return;
+    case 0x3f:                               // CCF
+        x.Bytes({0x80, 0x63, OffsetF, 0x9f}); // and byte [rbx+F], ~(N|H)
+        x.Bytes({0x80, 0x73, OffsetF, 0x10}); // xor byte [rbx+F], C
+        return;
+    default:
+        break;
+    }
+
+    if (opcode >= 0xc0)
+    {
+        // ALU A,n
+        EmitAlu(x, dst, true, instruction.operands[0]);
+    }
+    else if (opcode >= 0x80)
+    {
+        // ALU A,r
+        EmitAlu(x, dst, false, RegisterOffset(src));
+    }
+    else if (opcode >= 0x40)
+    {
+        // LD r,r'
+        x.Bytes({0x0f, 0xb6, 0x43, RegisterOffset(src)}); // movzx eax, byte [rbx+src]
+        x.Bytes({0x88, 0x43, RegisterOffset(dst)});       // mov [rbx+dst], al
+    }
+    else if (src == 0b110)
+    {
+        // LD r,n
+        x.Bytes({0xc6, 0x43, RegisterOffset(dst), instruction.operands[0]});
+    }
+    else if (src == 0b100)
+    {
+        // INC r: Z and H from the result, N cleared, C kept
+        x.Bytes({0xfe, 0x43, RegisterOffset(dst)}); // inc byte [rbx+r]
+        x.StoreFlagsFromLahf(FlagBitmaskZero | FlagBitmaskHalfCarry, 0x1f, 0);
+    }
+    else
+    {
+        // DEC r: Z and H from the result, N set, C kept
+        x.Bytes({0xfe, 0x4b, RegisterOffset(dst)}); // dec byte [rbx+r]
+        x.StoreFlagsFromLahf(FlagBitmaskZero | FlagBitmaskHalfCarry, 0x1f, FlagBitmaskN);
+    }
+}
+
+/// Emit a jump to `target` at the end of a block. A jump back to the start of the block loops natively while within budget.
+static void EmitJumpExit(X64Emitter &x, uint16_t target, uint16_t block_pc, size_t loop_start, uint16_t block_cycles)
+{
+    if (target == block_pc)
+    {
+        x.LoopIfWithinBudget(loop_start, block_cycles);
+    }
+    x.ExitWithPC(target);
+}
+
+// *********************************************************************************
+// JIT
+// *********************************************************************************
+
+JIT::JIT()
+{
+    void *memory = mmap(nullptr, CodeBufferSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED)
+    {
+        code_buffer = static_cast<uint8_t *>(memory);
+    }
+}
+
+JIT::~JIT()
+{
+    if (code_buffer != nullptr)
+    {
+        munmap(code_buffer, CodeBufferSize);
+    }
+}
+
+void JIT::Reset()
+{
+    code_buffer_used = 0;
+}
+
+void JIT::Compile(DecodedBlock &block, uint16_t pc)
+{
+    if (code_buffer == nullptr)
+    {
+        block.native_code_unsupported = true;
+        return;
+    }
+
+    X64Emitter x;
+    x.Prologue();
+    size_t loop_start = x.code.size();
+
+    // Only the instructions up to the first unsupported one are compiled
+    size_t count = 0;
+    uint16_t block_cycles = 0;
+    for (const auto &instruction : block.instructions)
+    {
+        if (TranslationOf(instruction.opcode) == Translation::Unsupported)
+        {
+            break;
+        }
+        block_cycles += instruction.opcode == 0xcb ? CPU::bit_opcode_table[instruction.operands[0]].cycles : instruction.cycles;
+        count++;
+    }
+
+    if (count == 0)
+    {
+        block.native_code_unsupported = true;
+        return;
+    }
+
+    uint16_t instruction_pc = pc;
+    bool exited = false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const DecodedInstruction &instruction = block.instructions[i];
+        uint8_t opcode = instruction.opcode;
+        uint16_t next_pc = instruction_pc + instruction.length;
+
+        if (TranslationOf(opcode) == Translation::Interpreted)
+        {
+            x.CallInterpreter(EncodeInstruction(opcode, instruction.operands), instruction_pc);
+            x.Bytes({0x85, 0xc0}); // test eax, eax
+            size_t executed = x.JumpIf(0x85); // jnz
+            x.Epilogue();                     // PC has been left at the instruction
+            x.PatchJumpToHere(executed);
+            x.Bytes({0x41, 0x01, 0xc5}); // add r13d, eax
+
+            if (IsIndirectControlFlow(opcode))
+            {
+                // CALL, RET, RST and JP (HL) set PC themselves, and always end the block
+                x.Epilogue();
+                exited = true;
+                break;
+            }
+            instruction_pc = next_pc;
+            continue;
+        }
+
+        uint8_t cycles = instruction.cycles;
+
+        if (opcode == 0x18 || opcode == 0xc3)
+        {
+            // JR e, JP nn
+            uint16_t target = opcode == 0x18 ? next_pc + static_cast<int8_t>(instruction.operands[0]) : instruction.operands[0] | (instruction.operands[1] << 8);
+            x.AddCycles(cycles);
+            EmitJumpExit(x, target, pc, loop_start, block_cycles);
+            exited = true;
+            break;
+        }
+
+        if (opcode == 0x20 || opcode == 0x28 || opcode == 0x30 || opcode == 0x38 || opcode == 0xc2 || opcode == 0xca || opcode == 0xd2 || opcode == 0xda)
+        {
+            // JR cc,e / JP cc,nn. The condition is encoded in bits 3-4: NZ, Z, NC, C
+            uint8_t condition = (opcode >> 3) & 0b11;
+            uint16_t target = opcode < 0x40 ? next_pc + static_cast<int8_t>(instruction.operands[0]) : instruction.operands[0] | (instruction.operands[1] << 8);
+            uint8_t flag = condition < 2 ? FlagBitmaskZero : FlagBitmaskC;
+            bool jump_if_set = condition & 1;
+
+            x.AddCycles(cycles);
+            x.Bytes({0xf6, 0x43, OffsetF, flag}); // test byte [rbx+F], flag
+            // Skip the taken path if the condition is false
+            size_t not_taken = x.JumpIf(jump_if_set ? 0x84 : 0x85); // jz / jnz
+            EmitJumpExit(x, target, pc, loop_start, block_cycles);
+            x.PatchJumpToHere(not_taken);
+            x.ExitWithPC(next_pc);
+            exited = true;
+            break;
+        }
+
+        EmitNative(x, instruction);
+        x.AddCycles(cycles);
+        instruction_pc = next_pc;
+    }
+
+    if (!exited)
+    {
+        // Fell through the last compiled instruction
+        x.ExitWithPC(instruction_pc);
+    }
+
+    if (code_buffer_used + x.code.size() > CodeBufferSize)
+    {
+        block.native_code_unsupported = true;
+        return;
+    }
+
+    uint8_t *native_code = code_buffer + code_buffer_used;
+    std::memcpy(native_code, x.code.data(), x.code.size());
+    code_buffer_used += x.code.size();
+
+    block.native_code = native_code;
+    block.native_cycles = block_cycles;
+    compiled_blocks++;
+}
+
+#endif // MEGABOY_JIT
@@ -0,0 +1,59 @@
+#pragma once
+
+#ifdef MEGABOY_JIT
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "block_cache.h"
+#include "native_block.h"
+
+/// Dynamic recompiler translating hot ROM blocks from the BlockCache into native x86-64 code (Linux only).
+///
+/// Register state stays in `CPU::GeneralRegisters`, the native code reads and writes the registers there directly.
+/// Loads, stores, jumps, INC/DEC and 8-bit ALU instructions on registers are translated to native instructions,
+/// everything else calls back into the interpreter through a thunk, one instruction at a time.
+///
+/// Compiled blocks are run by `CPU::run_native_code`, only within a cycle budget given by the caller (see `Gameboy::CyclesUntilNextEvent`), during which
+/// no peripheral changes anything the CPU can observe. A block that jumps back to its own start keeps looping natively as long
+/// as another pass fits in the budget. Instructions writing to ROM (MBC registers) or IO registers make the native code
+/// exit before the instruction, so the interpreter executes it with the peripherals in sync.
+///
+/// Instructions touching the interrupt state (EI, DI, RETI, HALT and STOP) are never compiled.
+/// The interpreter stays the fallback for everything else, and a correctness oracle in the tests.
+class JIT
+{
+public:
+    JIT();
+    ~JIT();
+
+    JIT(const JIT &) = delete;
+    JIT &operator=(const JIT &) = delete;
+
+    /// Compile a block to native code, setting its `native_code` and `native_cycles`.
+    /// Marks the block `native_code_unsupported` if nothing in it can be compiled.
+    void Compile(DecodedBlock &block, uint16_t pc);
+
+    /// Drop all native code. Must be called whenever the BlockCache is cleared.
+    void Reset();
+
+    /// Whether executable memory could be allocated for native code
+    [[nodiscard]] bool IsAvailable() const
+    {
+        return code_buffer != nullptr;
+    }
+
+    /// Number of times a block is entered before it is compiled
+    uint32_t compile_threshold = 32;
+    /// Number of blocks compiled since creation
+    uint64_t compiled_blocks = 0;
+
+private:
+    static constexpr size_t CodeBufferSize = 16 * 1024 * 1024;
+
+    uint8_t *code_buffer = nullptr;
+    size_t code_buffer_used = 0;
+};
+
+#endif // MEGABOY_JIT
@@ -0,0 +1,97 @@
+#include "native_block.h"
+#include "cpu.h"
+
+/// Whether a write to `address` only changes memory, and has no side effects on the MBC or the IO registers
+static bool IsPlainMemoryWrite(uint16_t address)
+{
+    return address >= 0x8000 && (address < 0xff00 || (address >= 0xff80 && address != 0xffff));
+}
+
+/// Whether every write an instruction would do goes to plain memory (see `IsPlainMemoryWrite`)
+static bool WritesOnlyPlainMemory(const CPU &cpu, uint8_t opcode, const uint8_t *operands)
+{
+    const auto &regs = cpu.regs;
+    uint16_t nn = operands[0] | (operands[1] << 8);
+
+    switch (opcode)
+    {
+    case 0x02: // LD (BC),A
+        return IsPlainMemoryWrite(regs.BC);
+    case 0x12: // LD (DE),A
+        return IsPlainMemoryWrite(regs.DE);
+    case 0x22: // LD (HL+),A
+    case 0x32: // LD (HL-),A
+    case 0x34: // INC (HL)
+    case 0x35: // DEC (HL)
+    case 0x36: // LD (HL),n
+    case 0x70:
+    case 0x71:
+    case 0x72:
+    case 0x73:
+    case 0x74:
+    case 0x75:
+    case 0x77: // LD (HL),r
+        return IsPlainMemoryWrite(regs.HL);
+    case 0x08: // LD (nn),SP
+        return IsPlainMemoryWrite(nn) && IsPlainMemoryWrite(nn + 1);
+    case 0xea: // LD (nn),A
+        return IsPlainMemoryWrite(nn);
+    case 0xe0: // LD (FF00+n),A
+        return IsPlainMemoryWrite(0xff00 + operands[0]);
+    case 0xe2: // LD (FF00+C),A
+        return IsPlainMemoryWrite(0xff00 + regs.C);
+    case 0xc5:
+    case 0xd5:
+    case 0xe5:
+    case 0xf5: // PUSH
+    case 0xc4:
+    case 0xcc:
+    case 0xcd:
+    case 0xd4:
+    case 0xdc: // CALL
+    case 0xc7:
+    case 0xcf:
+    case 0xd7:
+    case 0xdf:
+    case 0xe7:
+    case 0xef:
+    case 0xf7:
+    case 0xff: // RST
+        return IsPlainMemoryWrite(regs.SP - 1) && IsPlainMemoryWrite(regs.SP - 2);
+    case 0xcb:
+        // All CB instructions on (HL) except BIT write the result back
+        if ((operands[0] & 0b111) == RegisterCode::HLPtr && (operands[0] >> 6) != 0b01)
+        {
+            return IsPlainMemoryWrite(regs.HL);
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+uint32_t InterpretInstruction(CPU *cpu, uint32_t encoded, uint32_t pc)
+{
+    uint8_t opcode = encoded & 0xff;
+    uint8_t operands[2] = {static_cast<uint8_t>(encoded >> 8), static_cast<uint8_t>(encoded >> 16)};
+
+    if (!WritesOnlyPlainMemory(*cpu, opcode, operands))
+    {
+        cpu->regs.PC = pc;
+        return 0;
+    }
+
+    const CPU::Instruction &instruction = CPU::opcode_table[opcode];
+    cpu->current_pc = pc;
+    cpu->current_opcode = opcode;
+    cpu->regs.PC = pc + 1;
+    cpu->prefetched_operands = operands;
+    (cpu->*instruction.code)();
+    cpu->prefetched_operands = nullptr;
+    // Native code reads F directly
+    cpu->materialize_flags();
+
+    uint32_t cycles = instruction.cycles + cpu->additional_cycles_spent;
+    cpu->additional_cycles_spent = 0;
+    return cycles;
+}
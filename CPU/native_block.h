@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+
+class CPU;
+
+// Shared by the code generators that turn blocks from the BlockCache into native code:
+// the JIT (jit_x64.h) and the ahead-of-time recompiler (aot/StaticRecompiler.h).
+
+/// Signature of a block of native code.
+/// Runs the block at least once, and keeps looping while the block jumps back to its own start and another pass fits within `budget` cycles.
+/// Sets PC to the next instruction to execute.
+/// \param regs CPU::GeneralRegisters of `cpu`
+/// \returns the number of cycles spent
+using NativeBlock = uint32_t (*)(CPU *cpu, void *regs, uint32_t budget);
+
+enum class Translation
+{
+    /// Never compiled, native code exits before the instruction
+    Unsupported,
+    /// Executed through the interpreter thunk
+    Interpreted,
+    /// Translated to native code
+    Native
+};
+
+/// How native code executes an instruction
+inline Translation TranslationOf(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case 0x10: // STOP
+    case 0x76: // HALT
+    case 0xf3: // DI
+    case 0xfb: // EI
+    case 0xd9: // RETI
+    case 0xd3:
+    case 0xdb:
+    case 0xdd:
+    case 0xe3:
+    case 0xe4:
+    case 0xeb:
+    case 0xec:
+    case 0xed:
+    case 0xf4:
+    case 0xfc:
+    case 0xfd:
+        return Translation::Unsupported;
+    case 0x40: // LD B,B also reports mooneye test results
+        return Translation::Interpreted;
+    case 0x00:                                                 // NOP
+    case 0x01: case 0x11: case 0x21: case 0x31:                // LD rr,nn
+    case 0x03: case 0x13: case 0x23: case 0x33:                // INC rr
+    case 0x0b: case 0x1b: case 0x2b: case 0x3b:                // DEC rr
+    case 0x2f: case 0x37: case 0x3f:                           // CPL, SCF, CCF
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:     // JR
+    case 0xc3: case 0xc2: case 0xca: case 0xd2: case 0xda:     // JP
+    case 0xc6: case 0xce: case 0xd6: case 0xde:                // ALU A,n
+    case 0xe6: case 0xee: case 0xf6: case 0xfe:
+        return Translation::Native;
+    default:
+        break;
+    }
+
+    // Register code of (HL) in the opcode bits, see RegisterCode
+    constexpr uint8_t HLPtrCode = 0b110;
+    uint8_t dst = (opcode >> 3) & 0b111;
+    uint8_t src = opcode & 0b111;
+
+    // INC r, DEC r, LD r,n
+    if (opcode < 0x40 && (src == 0b100 || src == 0b101 || src == 0b110) && dst != HLPtrCode)
+    {
+        return Translation::Native;
+    }
+
+    // LD r,r' and ALU A,r
+    if (opcode >= 0x40 && opcode < 0xc0 && src != HLPtrCode && (opcode >= 0x80 || dst != HLPtrCode))
+    {
+        return Translation::Native;
+    }
+
+    return Translation::Interpreted;
+}
+
+/// Control flow instructions executed through the interpreter thunk
+inline bool IsIndirectControlFlow(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case 0xc0: case 0xc8: case 0xc9: case 0xd0: case 0xd8: // RET
+    case 0xc4: case 0xcc: case 0xcd: case 0xd4: case 0xdc: // CALL
+    case 0xc7: case 0xcf: case 0xd7: case 0xdf:            // RST
+    case 0xe7: case 0xef: case 0xf7: case 0xff:
+    case 0xe9:                                             // JP (HL)
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Pack an instruction for `InterpretInstruction`: the opcode in bits 0-7, followed by the two operand bytes
+inline uint32_t EncodeInstruction(uint8_t opcode, const uint8_t *operands)
+{
+    return opcode | (operands[0] << 8) | (operands[1] << 16);
+}
+
+/// Called from native code to execute an instruction that isn't translated, through the interpreter.
+/// \param encoded the instruction packed by `EncodeInstruction`
+/// \param pc address of the instruction
+/// \returns cycles spent, or 0 if the instruction would write to the MBC or an IO register.
+/// In that case nothing is executed, and PC is left at the instruction so the interpreter can take over.
+uint32_t InterpretInstruction(CPU *cpu, uint32_t encoded, uint32_t pc);
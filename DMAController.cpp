@@ -17,15 +17,13 @@ void DMAController::Reset()
 
 void DMAController::Step(uint16_t cycles)
 {
-
-    // If using mem.Write we trigger didWriteToIOAddress, which create an infinite loop and triggering another DMA transfer request
-    mem.memory[(uint16_t)IOAddress::DMATransferStartAddress] = last_requested_source_addr;
-
     if (!transfer_in_progress)
     {
         return;
     }
 
+    mem.oam_modified = true;
+
     while (current_bytes_transferred < 160 && cycles > 0)
     {
         mem.memory[DestinationBaseAddress + current_bytes_transferred] = mem.Read(current_source_address);
@@ -58,6 +56,11 @@ void DMAController::RequestTransfer(uint8_t addr_hibyte)
     current_source_address = addr_hibyte << 8;
 }
 
+uint8_t DMAController::GetLastRequestedSourceAddress() const
+{
+    return last_requested_source_addr;
+}
+
 bool DMAController::IsTransferInProgress() const
 {
     return transfer_in_progress;
@@ -30,6 +30,9 @@ public:
 
     void RequestTransfer(uint8_t addr_hibyte);
 
+    /// Value of the DMA transfer register (0xff46)
+    [[nodiscard]] uint8_t GetLastRequestedSourceAddress() const;
+
     [[nodiscard]] bool IsTransferInProgress() const;
 };
 
@@ -2,9 +2,10 @@
 // Created by sbeam on 09/12/2021.
 //
 
+#include <algorithm>
 #include "Gameboy.h"
 
-Gameboy::Gameboy() : mem(cartridge), cpu(mem), lcd(mem), dma(mem), joypad(mem), timer(mem)
+Gameboy::Gameboy() : mem(cartridge), cpu(mem), lcd(mem), dma(mem), joypad(mem)
 {
     // Set interrupt flag when timer overflows
     timer.didOverflow = [&]()
@@ -12,86 +13,377 @@ Gameboy::Gameboy() : mem(cartridge), cpu(mem), lcd(mem), dma(mem), joypad(mem),
         mem.SetInterruptFlag(Interrupt_Flag_Timer, true);
     };
 
-    mem.didWriteToIOAddress = [&](uint16_t addr, uint8_t value)
+    MapIORegisters();
+
+    ScheduleAll();
+}
+
+void Gameboy::MapIORegisters()
+{
+    mem.MapIORegister(static_cast<uint16_t>(IOAddress::Joypad), this,
+        [](void *gb, uint16_t)
+        {
+            return static_cast<Gameboy *>(gb)->joypad.ReadRegisterData();
+        },
+        [](void *gb, uint16_t, uint8_t value)
+        {
+            static_cast<Gameboy *>(gb)->joypad.WriteRegisterData(value);
+        });
+
+    mem.MapIORegister(0xff02, this, nullptr, [](void *gb, uint16_t address, uint8_t value)
     {
-        switch (addr)
+        auto &mem = static_cast<Gameboy *>(gb)->mem;
+        // print debug rom output, written to the serial port
+        if (value == 0x81)
         {
-        case (uint16_t)IOAddress::TimerCounter:
-            timer.SetCounter(value);
-            break;
-        case (uint16_t)IOAddress::TimerControl:
-            timer.SetTimerControl(value);
-            break;
-        case (uint16_t)IOAddress::TimerDivider:
-            timer.SetDividerRegister();
-            break;
-        case (uint16_t)IOAddress::TimerModule:
-            timer.SetModulo(value);
-            break;
-        case (uint16_t)IOAddress::DMATransferStartAddress:
-            // Initiate DMA transfer
-            dma.RequestTransfer(value);
-            break;
-        case (uint16_t)IOAddress::Joypad:
-            joypad.WriteRegisterData(value);
-            break;
-        default:
-            break;
+            char c = mem[0xff01];
+            printf("%c", c);
+            value = 0x0;
         }
-    };
+        mem[address] = value;
+    });
+
+    for (uint16_t address = (uint16_t)IOAddress::TimerDivider; address <= (uint16_t)IOAddress::TimerControl; address++)
+    {
+        mem.MapIORegister(address, this,
+            [](void *gb, uint16_t address)
+            {
+                return static_cast<Gameboy *>(gb)->ReadTimerRegister(address);
+            },
+            [](void *gb, uint16_t address, uint8_t value)
+            {
+                static_cast<Gameboy *>(gb)->WriteTimerRegister(address, value);
+            });
+    }
+
+    // LCD_Control - Window_X_Position
+    for (uint16_t address = 0xff40; address <= 0xff4b; address++)
+    {
+        mem.MapIORegister(address, this, nullptr, [](void *gb, uint16_t address, uint8_t value)
+        {
+            auto &gameboy = *static_cast<Gameboy *>(gb);
+            gameboy.mem[address] = value;
+            // The LCD only wakes up at its deadlines, or after the CPU wrote to its registers
+            gameboy.lcd_registers_written = true;
+        });
+    }
+
+    mem.MapIORegister(LCD::LCD_Stat_Register, this,
+        [](void *gb, uint16_t)
+        {
+            return static_cast<Gameboy *>(gb)->lcd.ReadStatRegister();
+        },
+        [](void *gb, uint16_t address, uint8_t value)
+        {
+            auto &gameboy = *static_cast<Gameboy *>(gb);
+            gameboy.mem[address] = value;
+            gameboy.lcd_registers_written = true;
+        });
+
+    // LY is read only
+    mem.MapIORegister(LCD::LCD_Y_Register, this,
+        [](void *gb, uint16_t)
+        {
+            return static_cast<Gameboy *>(gb)->lcd.current_scanline;
+        },
+        [](void *, uint16_t, uint8_t)
+        {
+        });
+
+    mem.MapIORegister(static_cast<uint16_t>(IOAddress::DMATransferStartAddress), this,
+        [](void *gb, uint16_t)
+        {
+            return static_cast<Gameboy *>(gb)->dma.GetLastRequestedSourceAddress();
+        },
+        [](void *gb, uint16_t, uint8_t value)
+        {
+            static_cast<Gameboy *>(gb)->RequestDMATransfer(value);
+        });
+}
+
+uint8_t Gameboy::ReadTimerRegister(uint16_t address)
+{
+    // The timer is only stepped at its deadlines, catch it up before reading it
+    SyncTimer(io_cycle);
+
+    switch (address)
+    {
+    case (uint16_t)IOAddress::TimerDivider:
+        return timer.GetDividerRegister();
+    case (uint16_t)IOAddress::TimerCounter:
+        return timer.GetCounter();
+    case (uint16_t)IOAddress::TimerModule:
+        return timer.GetModulo();
+    default:
+        return timer.GetTimerControl();
+    }
+}
+
+void Gameboy::WriteTimerRegister(uint16_t address, uint8_t value)
+{
+    // The timer is only stepped at its deadlines, catch it up before changing it
+    SyncTimer(io_cycle);
+
+    switch (address)
+    {
+    case (uint16_t)IOAddress::TimerCounter:
+        timer.SetCounter(value);
+        break;
+    case (uint16_t)IOAddress::TimerControl:
+        timer.SetTimerControl(value);
+        break;
+    case (uint16_t)IOAddress::TimerDivider:
+        timer.SetDividerRegister();
+        break;
+    case (uint16_t)IOAddress::TimerModule:
+        timer.SetModulo(value);
+        break;
+    default:
+        break;
+    }
+
+    scheduler.Schedule(Scheduler::Event::Timer, timer_cycle + timer.CyclesUntilNextEvent());
+}
+
+void Gameboy::RequestDMATransfer(uint8_t value)
+{
+    // Initiate DMA transfer
+    if (!dma.IsTransferInProgress())
+    {
+        dma_cycle = scheduler.now;
+    }
+    dma.RequestTransfer(value);
+    if (dma.IsTransferInProgress())
+    {
+        scheduler.Schedule(Scheduler::Event::DMA, scheduler.now);
+    }
 }
 
 void Gameboy::Reset()
 {
     cpu.reset();
     timer.Reset();
+    lcd.Reset();
     dma.Reset();
     cartridge.Reset();
-    mem[static_cast<uint16_t>(IOAddress::InterruptEnabled)] = 0;
-    mem[static_cast<uint16_t>(IOAddress::InterruptFlag)] = 0;
+    mem.interrupts.Reset();
+    ScheduleAll();
+}
+
+void Gameboy::ScheduleAll()
+{
+    scheduler.Reset();
+    timer_cycle = 0;
+    lcd_cycle = 0;
+    dma_cycle = 0;
+    io_cycle = 0;
+    lcd_registers_written = false;
+    scheduler.Schedule(Scheduler::Event::Timer, timer.CyclesUntilNextEvent());
+    ScheduleLCD();
 }
 
 ///
 /// \return Number of cycles the step took
 uint16_t Gameboy::Step()
 {
-
-    mem[static_cast<uint16_t>(IOAddress::Joypad)] = joypad.ReadRegisterData();
-
     // handle interrupts
     HandleInterrupts();
 
-    timer.Step(1);
+    if (cpu.is_halted && use_halt_fast_forward)
+    {
+        // Nothing happens until an interrupt wakes the CPU up, so skip straight to the cycle it could be requested at
+        uint16_t halted_cycles = CyclesUntilNextInterrupt();
+        if (halted_cycles > 1)
+        {
+            Advance(halted_cycles);
+            return halted_cycles;
+        }
+    }
 
-    uint16_t cycles = cpu.step();
-    for (int i = 0; i < cycles - 1; i++)
+    // The last pass through an idle loop must have read values that haven't changed since.
+    // Every further pass then reads the same values until the next event, so skip as many whole passes as fit before it.
+    if (cpu.use_idle_loop_skipping && cpu.idle_loop.active && cpu.regs.PC == cpu.idle_loop.loop_pc &&
+        CyclesSinceLastEvent() >= cpu.idle_loop.iteration_cycles)
     {
-        timer.Step(1);
+        uint16_t iterations = CyclesUntilNextEvent() / cpu.idle_loop.iteration_cycles;
+        if (iterations > 0)
+        {
+            uint16_t idle_cycles = iterations * cpu.idle_loop.iteration_cycles;
+            cpu.idle_loop.skipped_iterations += iterations;
+            cpu.idle_loop.skipped_cycles += idle_cycles;
+            Advance(idle_cycles);
+            return idle_cycles;
+        }
     }
-    // timer.Step(cycles);
 
-    lcd.Step(cycles);
-    dma.Step(cycles);
+    uint16_t cycles = 0;
 
-    // print debug rom output
+#if defined(MEGABOY_JIT) || defined(MEGABOY_AOT)
+    if (cpu.use_native_code)
+    {
+        // Native code runs a whole block within the event budget
+        cycles = cpu.run_native_code(CyclesUntilNextEvent());
+    }
+#endif
 
-    if (cpu.mem[0xff02] == 0x81)
+    if (cycles == 0)
     {
-        char c = cpu.mem[0xff01];
-        printf("%c", c);
-        // std::cout << c << std::endl; //
-        cpu.mem[0xff02] = 0x0;
+        // The timer is stepped one cycle ahead of the instruction
+        io_cycle = scheduler.now + 1;
+        if (scheduler.Deadline(Scheduler::Event::Timer) <= io_cycle)
+        {
+            SyncTimer(io_cycle);
+        }
+
+        cycles = cpu.step();
     }
 
+    Advance(cycles);
+
     return cycles;
 }
 
-void Gameboy::HandleInterrupts()
+uint64_t Gameboy::RunFrame(bool draw)
+{
+    lcd.skip_next_frame = !draw;
+    return Run(CyclesPerFrame, true);
+}
+
+uint64_t Gameboy::RunCycles(uint64_t cycles)
 {
+    return Run(cycles, false);
+}
+
+uint64_t Gameboy::Run(uint64_t cycles, bool stop_at_vblank)
+{
+    uint64_t start = scheduler.now;
+    uint64_t frame = lcd.frame_count;
+    run_deadline = start + cycles;
+
+    // Native code runs whole blocks, and could run past the breakpoint
+    bool use_native_code = cpu.use_native_code;
+    if (breakpoint)
+    {
+        cpu.use_native_code = false;
+    }
 
-    static const uint16_t irqJumpAddrs[] = {0x40, 0x48, 0x50, 0x58, 0x60};
-    static const Interrupt_Flag flags[] = {Interrupt_Flag_VBlank, Interrupt_Flag_LCD_Stat, Interrupt_Flag_Timer, Interrupt_Flag_Serial, Interrupt_Flag_Joypad};
+    while (scheduler.now < run_deadline)
+    {
+        Step();
 
+        if (stop_at_vblank && lcd.frame_count != frame)
+        {
+            break;
+        }
+        if (breakpoint && cpu.regs.PC == *breakpoint)
+        {
+            break;
+        }
+    }
+
+    run_deadline = Scheduler::Never;
+    cpu.use_native_code = use_native_code;
+    return scheduler.now - start;
+}
+
+void Gameboy::Advance(uint16_t cycles)
+{
+    scheduler.now += cycles;
+    io_cycle = scheduler.now;
+
+    if (scheduler.now >= scheduler.NextDeadline() || lcd_registers_written)
+    {
+        RunDueEvents();
+    }
+}
+
+void Gameboy::RunDueEvents()
+{
+    uint64_t now = scheduler.now;
+
+    if (scheduler.Deadline(Scheduler::Event::Timer) <= now)
+    {
+        SyncTimer(now);
+    }
+
+    if (scheduler.Deadline(Scheduler::Event::LCD) <= now)
+    {
+        SyncLCD(now);
+    }
+
+    if (lcd_registers_written)
+    {
+        bool was_enabled = lcd.IsEnabled();
+        lcd.RegistersWritten();
+        if (lcd.IsEnabled() != was_enabled)
+        {
+            // Turned on or off, the LCD starts over from here
+            lcd_cycle = now;
+            ScheduleLCD();
+        }
+        lcd_registers_written = false;
+    }
+
+    if (scheduler.Deadline(Scheduler::Event::DMA) <= now)
+    {
+        SyncDMA(now);
+    }
+}
+
+void Gameboy::SyncTimer(uint64_t cycle)
+{
+    if (cycle > timer_cycle)
+    {
+        timer.Step(static_cast<uint16_t>(cycle - timer_cycle));
+        timer_cycle = cycle;
+    }
+    scheduler.Schedule(Scheduler::Event::Timer, timer_cycle + timer.CyclesUntilNextEvent());
+}
+
+void Gameboy::SyncLCD(uint64_t cycle)
+{
+    // Step handles one scanline or mode change per call, so stop at every deadline on the way
+    uint64_t deadline = scheduler.Deadline(Scheduler::Event::LCD);
+    while (deadline <= cycle)
+    {
+        lcd.Step();
+        lcd_cycle = deadline;
+        deadline = lcd_cycle + lcd.CyclesUntilNextEvent();
+    }
+
+    scheduler.Schedule(Scheduler::Event::LCD, deadline);
+}
+
+void Gameboy::ScheduleLCD()
+{
+    if (lcd.IsEnabled())
+    {
+        scheduler.Schedule(Scheduler::Event::LCD, lcd_cycle + lcd.CyclesUntilNextEvent());
+    }
+    else
+    {
+        // Nothing happens until LCDC turns it back on
+        scheduler.Cancel(Scheduler::Event::LCD);
+    }
+}
+
+void Gameboy::SyncDMA(uint64_t cycle)
+{
+    dma.Step(static_cast<uint16_t>(cycle - dma_cycle));
+    dma_cycle = cycle;
+
+    if (dma.IsTransferInProgress())
+    {
+        scheduler.Schedule(Scheduler::Event::DMA, cycle + 1);
+    }
+    else
+    {
+        scheduler.Cancel(Scheduler::Event::DMA);
+    }
+}
+
+void Gameboy::HandleInterrupts()
+{
     // Interrupt handling should take ~5 cycles
     // TODO: wait some cycles
 
@@ -102,32 +394,70 @@ void Gameboy::HandleInterrupts()
     // Bit 3: Serial   Interrupt Enable  (INT $58)  (1=Enable)
     // Bit 4: Joypad   Interrupt Enable  (INT $60)  (1=Enable)
 
-    for (uint8_t i = 0; i < 5; i++)
+    if (mem.interrupts.Pending())
     {
-        auto ie = mem.Read(IOAddress::InterruptEnabled);
-        auto irqf = mem.Read(IOAddress::InterruptFlag);
-        if (mem.Read(IOAddress::InterruptEnabled) & mem.Read(IOAddress::InterruptFlag) & flags[i])
+        // TODO: maybe the one-instruction delay here (with !ime_just_enabled) must not there when an IRQ is waking up the cpu from HALT mode?
+        if (cpu.interrupt_master_enabled && !cpu.ime_just_enabled && !cpu.is_halted)
         {
-
-            // TODO: maybe the one-instruction delay here (with !ime_just_enabled) must not there when an IRQ is waking up the cpu from HALT mode?
-            if (cpu.interrupt_master_enabled && !cpu.ime_just_enabled && !cpu.is_halted)
-            {
-                cpu.interrupt_master_enabled = false;
-                cpu.push_pc();
-                // Clear the given interrupt flag again
-                mem.SetInterruptFlag(flags[i], false);
-                cpu.regs.PC = irqJumpAddrs[i];
-            }
-
-            cpu.is_halted = false;
-            break;
+            uint8_t interrupt = mem.interrupts.NextInterrupt();
+            cpu.interrupt_master_enabled = false;
+            cpu.push_pc();
+            // Clear the given interrupt flag again
+            mem.interrupts.Clear(static_cast<Interrupt_Flag>(1 << interrupt));
+            cpu.regs.PC = 0x40 + interrupt * 8;
         }
+
+        cpu.is_halted = false;
+    }
+
+    cpu.ime_just_enabled = false;
+}
+
+uint16_t Gameboy::CyclesUntilNextEvent() const
+{
+    if (dma.IsTransferInProgress())
+    {
+        return 0;
+    }
+
+    // A pending interrupt is dispatched before the next instruction
+    if (cpu.interrupt_master_enabled && mem.interrupts.Pending())
+    {
+        return 0;
     }
 
-    if (cpu.ime_just_enabled)
+    // The timer is stepped one cycle ahead of every instruction, so the next timer change must be strictly after the last cycle
+    uint64_t now = scheduler.now;
+    uint64_t timer_deadline = scheduler.Deadline(Scheduler::Event::Timer);
+    uint64_t timer_cycles = timer_deadline > now + 1 ? timer_deadline - now - 1 : 0;
+    uint64_t lcd_cycles = scheduler.Deadline(Scheduler::Event::LCD) - now;
+
+    return static_cast<uint16_t>(std::min<uint64_t>({timer_cycles, lcd_cycles, run_deadline - now, 0xffff}));
+}
+
+uint16_t Gameboy::CyclesUntilNextInterrupt() const
+{
+    if (dma.IsTransferInProgress())
     {
-        cpu.ime_just_enabled = false;
+        return 0;
     }
+
+    // The timer hasn't changed since it was last stepped, so the overflow is still the same number of cycles from there
+    uint64_t now = scheduler.now;
+    uint64_t timer_cycles = timer_cycle + timer.CyclesUntilOverflow() - now;
+    uint64_t lcd_cycles = scheduler.Deadline(Scheduler::Event::LCD) - now;
+
+    return static_cast<uint16_t>(std::min<uint64_t>({timer_cycles, lcd_cycles, run_deadline - now, 0xffff}));
+}
+
+uint16_t Gameboy::CyclesSinceLastEvent() const
+{
+    uint64_t now = scheduler.now;
+    uint64_t timer_cycles = timer.CyclesSinceLastEvent() + (now - timer_cycle);
+    // The LCD is only ever at an event
+    uint64_t lcd_cycles = now - lcd_cycle;
+
+    return static_cast<uint16_t>(std::min<uint64_t>({timer_cycles, lcd_cycles, 0xffff}));
 }
 
 void Gameboy::Start()
@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include <optional>
 #include "CPU/cpu.h"
 #include "HostMemory.h"
 #include "Timer.h"
 #include "LCD/lcd.h"
 #include "DMAController.h"
 #include "Joypad.h"
+#include "Scheduler.h"
 
 class Gameboy
 {
@@ -17,6 +19,15 @@ class Gameboy
 public:
     bool IsDoubleSpeedMode = false;
 
+    /// Step all peripherals at once up to the next possible interrupt while the CPU is halted, instead of one cycle per step
+    bool use_halt_fast_forward = true;
+
+    /// Cycles of a whole frame: 154 scanlines of 456 cycles
+    static constexpr uint32_t CyclesPerFrame = 70224;
+
+    /// `RunFrame` and `RunCycles` return as soon as PC reaches this address
+    std::optional<uint16_t> breakpoint;
+
     Cartridge cartridge; // ORDER DEPENDENCY
     HostMemory mem;      // ORDER DEPENDENCY
     CPU cpu;
@@ -24,6 +35,8 @@ public:
     LCD lcd;
     DMAController dma;
     Joypad joypad;
+    /// Master clock, and when the timer, LCD and DMA next need to be stepped
+    Scheduler scheduler;
 
     /*
     enum InterruptFlag : uint8_t
@@ -43,4 +56,65 @@ public:
 
     uint16_t Step();
     void HandleInterrupts();
+
+    /// Run until the LCD enters VBlank with the whole frame drawn, or until PC reaches `breakpoint`.
+    /// No frame is drawn while the LCD is off, so then it returns after `CyclesPerFrame` cycles instead.
+    /// \param draw whether to draw the frame, which skips all pixel work for frames that aren't shown (see `LCD::skip_next_frame`)
+    /// \return the number of cycles run
+    uint64_t RunFrame(bool draw = true);
+
+    /// Run for `cycles` cycles, finishing the instruction they end in, or until PC reaches `breakpoint`.
+    /// \return the number of cycles run
+    uint64_t RunCycles(uint64_t cycles);
+
+    /// Number of cycles the CPU can run before anything it could observe changes outside of it:
+    /// a timer register or LCD mode/line change, a DMA transfer or an interrupt being dispatched.
+    /// Peripherals can be stepped once for all of these cycles afterwards with the same result as stepping them after every instruction.
+    [[nodiscard]] uint16_t CyclesUntilNextEvent() const;
+
+    /// Number of cycles until the next interrupt could be requested: a timer overflow or an LCD mode or line change (VBlank, STAT).
+    /// Joypad interrupts come from outside and are checked at the start of every step, so they wait at most this long.
+    /// 0 while a DMA transfer is in progress.
+    [[nodiscard]] uint16_t CyclesUntilNextInterrupt() const;
+
+    /// Number of cycles since the timer or LCD last changed anything the CPU can observe
+    [[nodiscard]] uint16_t CyclesSinceLastEvent() const;
+
+private:
+    /// Cycle each component has been stepped up to. Between deadlines they are behind `scheduler.now`.
+    uint64_t timer_cycle = 0;
+    uint64_t lcd_cycle = 0;
+    uint64_t dma_cycle = 0;
+    /// Cycle the timer is at when the CPU accesses its registers. The timer is stepped one cycle ahead of every instruction.
+    uint64_t io_cycle = 0;
+    /// Set when the CPU wrote to an LCD register, which the LCD applies once the instruction is done
+    bool lcd_registers_written = false;
+    /// Cycle `RunFrame` or `RunCycles` returns at. Halts and idle loops are not skipped past it.
+    uint64_t run_deadline = Scheduler::Never;
+
+    uint64_t Run(uint64_t cycles, bool stop_at_vblank);
+
+    /// Advance the master clock after the CPU spent `cycles`, and step the components whose deadline was reached
+    void Advance(uint16_t cycles);
+    void RunDueEvents();
+
+    /// Step a component up to `cycle` and schedule its next deadline
+    void SyncTimer(uint64_t cycle);
+    void SyncLCD(uint64_t cycle);
+    void SyncDMA(uint64_t cycle);
+
+    /// Schedule all components from their current state, after a reset
+    void ScheduleAll();
+    /// Schedule the next LCD event, or none while the LCD is off
+    void ScheduleLCD();
+
+    /// Bind the registers of the timer, LCD, DMA, joypad and serial port to their handlers
+    void MapIORegisters();
+
+    /// Handlers of the timer registers (0xff04 - 0xff07)
+    uint8_t ReadTimerRegister(uint16_t address);
+    void WriteTimerRegister(uint16_t address, uint8_t value);
+
+    /// Handler of the DMA transfer register (0xff46)
+    void RequestDMATransfer(uint8_t value);
 };
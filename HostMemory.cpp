@@ -11,9 +11,88 @@
 HostMemory::HostMemory(Cartridge &cartridge) noexcept : cartridge(cartridge)
 {
     std::cout << "HostMemory()";
+
+    for (int page = 0x80; page <= 0xff; page++)
+    {
+        read_pages[page] = &memory[page << 8];
+        write_pages[page] = &memory[page << 8];
+    }
+
+    // 0xE000 - 0xFDFF: Echo RAM
+    // This section mirrors working RAM (0xC000 - 0xDFFF)
+    for (int page = 0xe0; page <= 0xfd; page++)
+    {
+        read_pages[page] = &memory[(page - 0x20) << 8];
+    }
+
+    // IO registers
+    read_pages[0xff] = nullptr;
+    write_pages[0xff] = nullptr;
+
+    // Tile data and tile maps, so writes mark the tiles to decode and draw again
+    for (int page = TileDataStart >> 8; page < TileMapEnd >> 8; page++)
+    {
+        write_pages[page] = nullptr;
+    }
+    modified_tiles.fill(true);
+
+    // OAM, so writes mark the sprites to sort onto lines again
+    write_pages[OAMStart >> 8] = nullptr;
+
+    cartridge.didSwitchROMBank = [this]()
+    {
+        MapROMPages();
+        code_generation++;
+    };
+
+    MapIORegister(static_cast<uint16_t>(IOAddress::Boot_ROM_Disabled), this, nullptr, [](void *component, uint16_t address, uint8_t value)
+    {
+        auto &mem = *static_cast<HostMemory *>(component);
+        mem.memory[address] = value;
+        mem.MapROMPages();
+        mem.code_generation++;
+    });
+
+    MapIORegister(static_cast<uint16_t>(IOAddress::InterruptFlag), &interrupts,
+        [](void *interrupts, uint16_t)
+        {
+            return static_cast<InterruptController *>(interrupts)->GetInterruptFlags();
+        },
+        [](void *interrupts, uint16_t, uint8_t value)
+        {
+            static_cast<InterruptController *>(interrupts)->SetInterruptFlags(value);
+        });
+
+    MapIORegister(static_cast<uint16_t>(IOAddress::InterruptEnabled), &interrupts,
+        [](void *interrupts, uint16_t)
+        {
+            return static_cast<InterruptController *>(interrupts)->GetInterruptEnable();
+        },
+        [](void *interrupts, uint16_t, uint8_t value)
+        {
+            static_cast<InterruptController *>(interrupts)->SetInterruptEnable(value);
+        });
+
     Write(IOAddress::Boot_ROM_Disabled, 0);
 }
 
+void HostMemory::MapROMPages()
+{
+    const uint8_t *fixed_bank = cartridge.GetROMBankData(0);
+    const uint8_t *switchable_bank = cartridge.GetROMBankData(cartridge.GetROMBank());
+
+    for (int page = 0; page < 0x40; page++)
+    {
+        read_pages[page] = fixed_bank + (page << 8);
+        read_pages[page + 0x40] = switchable_bank + (page << 8);
+    }
+
+    if (!memory[static_cast<uint16_t>(IOAddress::Boot_ROM_Disabled)])
+    {
+        read_pages[0] = DMG_ROM_bin;
+    }
+}
+
 uint8_t &HostMemory::operator[](uint16_t index)
 {
     /*
@@ -30,51 +109,70 @@ uint8_t &HostMemory::operator[](uint16_t index)
     return memory[index];
 }
 
-uint8_t HostMemory::Read(uint16_t address) const
+uint16_t HostMemory::GetCodeBank(uint16_t address) const
 {
     if (!memory[static_cast<uint16_t>(IOAddress::Boot_ROM_Disabled)] && address <= 0xff)
     {
-        return DMG_ROM_bin[address];
-    }
-
-    if (address <= 0x7fff)
-    {
-        return cartridge.Read(address);
+        return BootROMCodeBank;
     }
 
-    // 0xE000 - 0xFDFF: Echo RAM
-    // This section mirrors working RAM (0xC000 - 0xDFFF)
-    //
-    if (address >= 0xE000 && address <= 0xFDFF)
+    if (address >= 0x4000 && address <= 0x7fff)
     {
-        address -= 0x2000;
+        return cartridge.GetROMBank();
     }
 
-    return memory[address];
+    return 0;
 }
 
-void HostMemory::Write(const uint16_t address, const uint8_t value)
+void HostMemory::WriteToHandledPage(const uint16_t address, const uint8_t value)
 {
     if (address <= 0x7fff)
     {
+        // Maps the ROM bank switched to, if any
         cartridge.Write(value, address);
     }
+    else if (IsIORegister(address))
+    {
+        const IORegister &reg = io_registers[IORegisterIndex(address)];
+        if (reg.write != nullptr)
+        {
+            reg.write(reg.component, address, value);
+        }
+        else
+        {
+            memory[address] = value;
+        }
+    }
     else
     {
         memory[address] = value;
-    }
 
-    // todo:
+        if (address >= TileDataStart && address < TileMapEnd)
+        {
+            vram_generation++;
+            if (address < TileDataEnd)
+            {
+                modified_tiles[(address - TileDataStart) >> 4] = true;
+            }
+        }
+        else if (address >= OAMStart && address < OAMEnd)
+        {
+            oam_modified = true;
+        }
 
-    if (address >= 0xff00)
-    {
-        if (didWriteToIOAddress != nullptr)
+        // A RAM page (or HRAM) flagged as holding decoded code
+        if (code_pages[address >> 8])
         {
-            didWriteToIOAddress(address, value);
+            CodePageWasWritten(address >> 8);
         }
     }
 }
 
+void HostMemory::MapIORegister(uint16_t address, void *component, IOReadHandler read, IOWriteHandler write)
+{
+    io_registers[IORegisterIndex(address)] = {read, write, component};
+}
+
 void HostMemory::Write(IOAddress address, uint8_t value)
 {
     Write(static_cast<uint16_t>(address), value);
@@ -4,19 +4,11 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <functional>
 #include "cartridge/Cartridge.h"
-
-enum Interrupt_Flag: uint8_t
-{
-    Interrupt_Flag_VBlank = 1,
-    Interrupt_Flag_LCD_Stat = 1 << 1,
-    Interrupt_Flag_Timer = 1 << 2,
-    Interrupt_Flag_Serial = 1 << 3,
-    Interrupt_Flag_Joypad = 1 << 4
-};
-
+#include "InterruptController.h"
 
 /*
     $FF00	        Controller
@@ -121,6 +113,19 @@ enum class IOAddress : uint16_t
 
 };
 
+/// Computes the value of an IO register when it is read
+using IOReadHandler = uint8_t (*)(void *component, uint16_t address);
+/// Applies a write to an IO register. Stores the value in `HostMemory::memory` itself if the register is kept there.
+using IOWriteHandler = void (*)(void *component, uint16_t address, uint8_t value);
+
+/// Handlers bound to a memory mapped IO register by the component owning it
+struct IORegister
+{
+    IOReadHandler read = nullptr;
+    IOWriteHandler write = nullptr;
+    void *component = nullptr;
+};
+
 class HostMemory {
 
 public:
@@ -129,40 +134,183 @@ public:
 
     HostMemory() = delete;
 
-    /// Called when a value is written to an memory mapped io address (0xff00 - 0xffff)
-    std::function<void(uint16_t,uint8_t)> didWriteToIOAddress = nullptr;
-
+    /// The byte backing an address, bypassing the MBC and the IO register handlers
     uint8_t& operator[] (uint16_t index);
 
     /// Read a byte from the bus
-    [[nodiscard]] uint8_t Read(uint16_t address) const;
+    [[nodiscard]] uint8_t Read(uint16_t address) const
+    {
+        if (const uint8_t *page = read_pages[address >> 8])
+        {
+            return page[address & 0xff];
+        }
+        return ReadFromHandledPage(address);
+    }
 
-    /// Read a byte from the bus
+    /// Read an IO register
     [[nodiscard]] uint8_t Read( IOAddress address ) const
     {
-        return memory[static_cast<uint16_t>(address)];
+        auto io_address = static_cast<uint16_t>(address);
+        const IORegister &reg = io_registers[IORegisterIndex(io_address)];
+        return reg.read != nullptr ? reg.read(reg.component, io_address) : memory[io_address];
     }
 
     /// Write a byte to a given address on the bus
-    void Write(uint16_t address, uint8_t value);
+    void Write(uint16_t address, uint8_t value)
+    {
+        if (uint8_t *page = write_pages[address >> 8])
+        {
+            page[address & 0xff] = value;
+        }
+        else
+        {
+            WriteToHandledPage(address, value);
+        }
+    }
 
     void Write(IOAddress address, uint8_t value);
 
+    /// Bind handlers to an IO register (0xff00 - 0xff7f or 0xffff), called with `component` when the CPU reads or writes it.
+    /// Without a read handler the register reads what was last stored in `memory`, and without a write handler writes are stored there.
+    void MapIORegister(uint16_t address, void *component, IOReadHandler read, IOWriteHandler write);
+
     void SetInterruptFlag( Interrupt_Flag flag , bool enabled )
     {
         if( enabled ){
-            memory[static_cast<uint16_t>(IOAddress::InterruptFlag)] |= static_cast<uint8_t>(flag);
+            interrupts.Request(flag);
         } else {
-            memory[static_cast<uint16_t>(IOAddress::InterruptFlag)] &= ~static_cast<uint8_t>(flag);
+            interrupts.Clear(flag);
         }
     }
 
+    /// IF and IE, mapped to 0xff0f and 0xffff
+    InterruptController interrupts;
+
     uint8_t memory[UINT16_MAX+1]{};
 
+    // *********************************************************************************
+    // Predecoded code tracking (see BlockCache)
+    // *********************************************************************************
+
+    /// Bank id returned by `GetCodeBank` while the boot ROM is mapped into 0x0000 - 0x00ff
+    static constexpr uint16_t BootROMCodeBank = 0xffff;
+
+    /// Identifies what is currently mapped at a code address, so predecoded instructions can be keyed by it.
+    /// \returns the ROM bank mapped at `address`, `BootROMCodeBank` for the boot ROM, and 0 for everything else.
+    [[nodiscard]] uint16_t GetCodeBank(uint16_t address) const;
+
+    /// Flag a 256 byte RAM page as holding predecoded instructions, so writes to it are reported in `modified_code_pages`.
+    void MarkCodePage(uint8_t page)
+    {
+        code_pages[page] = true;
+        // Writes to the page now need to be seen by WriteToHandledPage
+        write_pages[page] = nullptr;
+    }
+
+    /// Incremented every time previously decoded code might have changed: writes to a flagged code page,
+    /// switching to another ROM bank, loading a ROM and disabling the boot ROM.
+    uint32_t code_generation = 0;
+
+    /// Code pages written to since they were flagged. Cleared by the BlockCache when it drops the decoded code of a page.
+    std::array<bool, 256> modified_code_pages{};
+
+    // *********************************************************************************
+    // Tile data and tile map tracking (see TileCache and BackgroundLayer)
+    // *********************************************************************************
+
+    /// VRAM holding tile data: 384 tiles of 16 bytes in 0x8000 - 0x97ff
+    static constexpr uint16_t TileDataStart = 0x8000;
+    static constexpr uint16_t TileDataEnd = 0x9800;
+    static constexpr uint16_t TileCount = (TileDataEnd - TileDataStart) / 16;
+    /// VRAM holding the two 32x32 tile maps, right after the tile data
+    static constexpr uint16_t TileMapStart = 0x9800;
+    static constexpr uint16_t TileMapEnd = 0xa000;
+
+    /// Tiles written to through `Write` since the TileCache last decoded them. All set initially.
+    std::array<bool, TileCount> modified_tiles{};
+
+    /// Incremented on every write to tile data or the tile maps through `Write`
+    uint64_t vram_generation = 0;
+
+    // *********************************************************************************
+    // Sprite attribute tracking (see LCD::DrawSprites)
+    // *********************************************************************************
+
+    /// OAM: 40 sprites of 4 bytes in 0xfe00 - 0xfe9f
+    static constexpr uint16_t OAMStart = 0xfe00;
+    static constexpr uint16_t OAMEnd = 0xfea0;
+
+    /// Set by writes to OAM through `Write` and by DMA transfers, until the LCD has sorted the sprites onto lines again. Set initially.
+    bool oam_modified = true;
+
+
+    /// Point the pages of 0x0000 - 0x7fff at the boot ROM and the ROM banks currently selected.
+    /// Called when the boot ROM is disabled, and by the cartridge when it switches ROM bank.
+    void MapROMPages();
 
 private:
 
     Cartridge &cartridge;
 
+    std::array<bool, 256> code_pages{};
+
+    /// Where each 256 byte page of the address space is read from: the boot ROM, a ROM bank, or `memory`
+    /// (with echo RAM pointing at the working RAM it mirrors). nullptr for the IO page, read by `ReadFromHandledPage`.
+    std::array<const uint8_t *, 256> read_pages{};
+
+    /// Where each 256 byte page of the address space is written to,
+    /// or nullptr for pages where writes have side effects, and are handled by `WriteToHandledPage`:
+    /// MBC registers in the ROM area, IO registers, VRAM, OAM, and pages flagged by `MarkCodePage`.
+    std::array<uint8_t *, 256> write_pages{};
+
+    /// IO registers 0xff00 - 0xff7f, followed by 0xffff
+    std::array<IORegister, 0x81> io_registers{};
+
+    static constexpr uint8_t IORegisterIndex(uint16_t address)
+    {
+        return address == 0xffff ? 0x80 : static_cast<uint8_t>(address - 0xff00);
+    }
+
+    static constexpr bool IsIORegister(uint16_t address)
+    {
+        return (address >= 0xff00 && address < 0xff80) || address == 0xffff;
+    }
+
+    /// Reads from the pages without a pointer in `read_pages`
+    [[nodiscard]] uint8_t ReadFromHandledPage(uint16_t address) const
+    {
+        if (IsIORegister(address))
+        {
+            const IORegister &reg = io_registers[IORegisterIndex(address)];
+            if (reg.read != nullptr)
+            {
+                return reg.read(reg.component, address);
+            }
+        }
+
+        return memory[address];
+    }
+
+    /// Writes to the pages without a pointer in `write_pages`
+    void WriteToHandledPage(uint16_t address, uint8_t value);
+
+    static constexpr bool IsVRAMPage(uint8_t page)
+    {
+        return page >= (TileDataStart >> 8) && page < (TileMapEnd >> 8);
+    }
+
+    /// Called for writes to a page flagged by `MarkCodePage`
+    void CodePageWasWritten(uint8_t page)
+    {
+        code_pages[page] = false;
+        modified_code_pages[page] = true;
+        code_generation++;
+        // Writes to IO registers, VRAM and OAM are always handled
+        if (page != 0xff && page != (OAMStart >> 8) && !IsVRAMPage(page))
+        {
+            write_pages[page] = &memory[page << 8];
+        }
+    }
+
 
 };
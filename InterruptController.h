@@ -0,0 +1,92 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+enum Interrupt_Flag: uint8_t
+{
+    Interrupt_Flag_VBlank = 1,
+    Interrupt_Flag_LCD_Stat = 1 << 1,
+    Interrupt_Flag_Timer = 1 << 2,
+    Interrupt_Flag_Serial = 1 << 3,
+    Interrupt_Flag_Joypad = 1 << 4
+};
+
+/// IF and IE, and the interrupts both requested and enabled.
+///
+/// The pending interrupts are checked before every instruction, but only change when IF or IE is written or a peripheral requests an interrupt,
+/// so they are kept up to date on those changes and checking for an interrupt is a single load.
+class InterruptController
+{
+public:
+    static constexpr uint8_t InterruptMask = 0b11111;
+
+    void Reset()
+    {
+        requested = 0;
+        enabled = 0;
+        pending = 0;
+    }
+
+    /// Interrupts requested in IF and enabled in IE, with bit 0 (VBlank) the highest priority
+    [[nodiscard]] uint8_t Pending() const
+    {
+        return pending;
+    }
+
+    /// Index of the highest priority pending interrupt, which is dispatched to 0x40 + 8 * index. Only valid if any is pending.
+    [[nodiscard]] uint8_t NextInterrupt() const
+    {
+        return static_cast<uint8_t>(std::countr_zero(pending));
+    }
+
+    /// Set the bit of an interrupt in IF, as a peripheral does when it requests it
+    void Request(Interrupt_Flag flag)
+    {
+        requested |= flag;
+        UpdatePending();
+    }
+
+    /// Clear the bit of an interrupt in IF, as dispatching it does
+    void Clear(Interrupt_Flag flag)
+    {
+        requested &= ~flag;
+        UpdatePending();
+    }
+
+    /// FF0F - IF Interrupt Flag (R/W)
+    [[nodiscard]] uint8_t GetInterruptFlags() const
+    {
+        return requested;
+    }
+
+    /// FF0F - IF Interrupt Flag (R/W)
+    void SetInterruptFlags(uint8_t value)
+    {
+        requested = value;
+        UpdatePending();
+    }
+
+    /// FFFF - IE - Interrupt Enable (R/W)
+    [[nodiscard]] uint8_t GetInterruptEnable() const
+    {
+        return enabled;
+    }
+
+    /// FFFF - IE - Interrupt Enable (R/W)
+    void SetInterruptEnable(uint8_t value)
+    {
+        enabled = value;
+        UpdatePending();
+    }
+
+private:
+    uint8_t requested = 0;
+    uint8_t enabled = 0;
+    uint8_t pending = 0;
+
+    void UpdatePending()
+    {
+        pending = requested & enabled & InterruptMask;
+    }
+};
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cstring>
+#include "background_layer.h"
+
+void BackgroundLayer::CopyLine(uint8_t y, uint8_t scroll_x, bool unsigned_tile_data, uint8_t *dst, int width)
+{
+    if (unsigned_tile_data != drawn_with_unsigned_tile_data)
+    {
+        // Map entries now refer to other tiles
+        drawn_with_unsigned_tile_data = unsigned_tile_data;
+        row_generations.fill(Unchecked);
+    }
+
+    uint8_t tile_row = y / TileCache::TileHeight;
+    if (row_generations[tile_row] != mem.vram_generation)
+    {
+        UpdateTileRow(tile_row);
+    }
+
+    const uint8_t *line = &pixels[y * Size];
+    int width_before_edge = std::min(width, Size - scroll_x);
+    memcpy(dst, line + scroll_x, width_before_edge);
+    memcpy(dst + width_before_edge, line, width - width_before_edge);
+}
+
+void BackgroundLayer::UpdateTileRow(uint8_t tile_row)
+{
+    for (int tile_x = 0; tile_x < TileMapWidth; tile_x++)
+    {
+        int cell = tile_row * TileMapWidth + tile_x;
+        uint8_t tile_id = mem.memory[tile_map_address + cell];
+        // Signed ids index the tiles around 0x9000, which is tile 256
+        uint16_t tile = drawn_with_unsigned_tile_data ? tile_id : 256 + static_cast<int8_t>(tile_id);
+        uint32_t version = tile_cache.Version(tile);
+
+        if (cell_tiles[cell] == tile && cell_versions[cell] == version)
+        {
+            continue;
+        }
+        cell_tiles[cell] = tile;
+        cell_versions[cell] = version;
+
+        const uint8_t *tile_pixels = tile_cache.GetTile(tile);
+        uint8_t *dst = &pixels[tile_row * TileCache::TileHeight * Size + tile_x * TileCache::TileWidth];
+        for (int y = 0; y < TileCache::TileHeight; y++)
+        {
+            memcpy(&dst[y * Size], &tile_pixels[y * TileCache::TileWidth], TileCache::TileWidth);
+        }
+    }
+
+    row_generations[tile_row] = mem.vram_generation;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "../HostMemory.h"
+#include "tile_cache.h"
+
+/// The 256x256 color indices of a tile map drawn with the tiles it refers to, which background lines are copied from at the scroll position.
+///
+/// Tile maps and tile data mostly stay the same from frame to frame, while drawing a line from them takes 32 map lookups and tile rows.
+/// A row of tiles is only checked again after a write to VRAM (see `HostMemory::vram_generation`), and then only the tiles whose
+/// map entry or tile data changed are drawn again.
+class BackgroundLayer
+{
+public:
+    static constexpr int Size = 256;
+
+    /// \param tile_map_address 0x9800 or 0x9c00
+    BackgroundLayer(HostMemory &mem, TileCache &tile_cache, uint16_t tile_map_address) : mem(mem), tile_cache(tile_cache), tile_map_address(tile_map_address)
+    {
+        row_generations.fill(Unchecked);
+        cell_tiles.fill(NoTile);
+    }
+
+    /// Copy `width` pixels of a line of the layer to `dst`, starting at `scroll_x` and wrapping around at the right edge
+    /// \param y line of the layer (0-255)
+    /// \param unsigned_tile_data whether tile ids index tile data from 0x8000, rather than signed from 0x9000 (LCDC bit 4)
+    void CopyLine(uint8_t y, uint8_t scroll_x, bool unsigned_tile_data, uint8_t *dst, int width = Size);
+
+private:
+    static constexpr int TileMapWidth = 32;
+    static constexpr uint64_t Unchecked = UINT64_MAX;
+    static constexpr uint16_t NoTile = UINT16_MAX;
+
+    HostMemory &mem;
+    TileCache &tile_cache;
+    uint16_t tile_map_address;
+    /// Tile data addressing the map entries were drawn with
+    bool drawn_with_unsigned_tile_data = false;
+
+    /// `HostMemory::vram_generation` each row of tiles was last checked at
+    std::array<uint64_t, TileMapWidth> row_generations{};
+    /// Tile (0-383) and its `TileCache::Version` each map entry was last drawn with
+    std::array<uint16_t, TileMapWidth * TileMapWidth> cell_tiles{};
+    std::array<uint32_t, TileMapWidth * TileMapWidth> cell_versions{};
+
+    uint8_t pixels[Size * Size] = {};
+
+    /// Draw the tiles of a row whose map entry or tile data changed since they were last drawn
+    void UpdateTileRow(uint8_t tile_row);
+};
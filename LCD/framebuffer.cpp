@@ -0,0 +1,47 @@
+#include <array>
+#include "framebuffer.h"
+
+namespace
+{
+    /// The color each of the 4 shades of gray is stored as, from white to black, by pixel format
+    constexpr std::array<uint32_t, 4> Shades[] = {
+        {0, 1, 2, 3},                     // Indexed2, packed after mapping
+        {0xff, 0xaa, 0x55, 0x00},         // Gray8
+        {0xffff, 0xad55, 0x52aa, 0x0000}, // RGB565
+        PaletteMapper::RGBAShades,        // RGBA8888
+    };
+
+    /// Bytes each pixel is mapped to, before Indexed2 pixels are packed
+    constexpr int BytesPerPixel[] = {1, 1, 2, 4};
+}
+
+int Framebuffer::LineBytes(PixelFormat format)
+{
+    return format == PixelFormat::Indexed2 ? Width / 4 : Width * BytesPerPixel[static_cast<int>(format)];
+}
+
+void Framebuffer::SetFormat(PixelFormat pixel_format)
+{
+    format = pixel_format;
+    data.assign(LineBytes(format) * Height, 0);
+}
+
+void Framebuffer::WriteLine(uint8_t y, const uint8_t *pixels, uint8_t bg_palette, uint8_t obj_palette_0, uint8_t obj_palette_1)
+{
+    auto format_index = static_cast<int>(format);
+    palette_mapper.SetPalettes(bg_palette, obj_palette_0, obj_palette_1, Shades[format_index]);
+    uint8_t *dst = &data[y * LineBytes(format)];
+
+    if (format != PixelFormat::Indexed2)
+    {
+        palette_mapper.Map(pixels, dst, BytesPerPixel[format_index], Width);
+        return;
+    }
+
+    uint8_t shades[Width];
+    palette_mapper.Map(pixels, shades, 1, Width);
+    for (int x = 0; x < Width; x += 4)
+    {
+        *dst++ = shades[x] << 6 | shades[x + 1] << 4 | shades[x + 2] << 2 | shades[x + 3];
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "palette_mapper.h"
+
+/// How the pixels of a `Framebuffer` are stored
+enum class PixelFormat : uint8_t
+{
+    /// 2 bits per pixel: the shade from 0 (white) to 3 (black), with the leftmost of every 4 pixels in the highest bits
+    Indexed2,
+    /// 1 byte per pixel: 0xff for white to 0x00 for black
+    Gray8,
+    /// 2 bytes per pixel, lowest byte first: 5 bits of red, 6 of green and 5 of blue from the highest bit down
+    RGB565,
+    /// 4 bytes per pixel: red, green, blue and alpha
+    RGBA8888
+};
+
+/// The 160x144 pixels of the screen, in the pixel format the frontend draws them in.
+/// The LCD writes every line it draws, mapped through the palettes it is drawn with.
+class Framebuffer
+{
+public:
+    static constexpr int Width = 160;
+    static constexpr int Height = 144;
+
+    Framebuffer()
+    {
+        SetFormat(PixelFormat::RGBA8888);
+    }
+
+    /// Store the lines drawn from now on in `pixel_format`. Clears the framebuffer.
+    void SetFormat(PixelFormat pixel_format);
+
+    [[nodiscard]] PixelFormat Format() const
+    {
+        return format;
+    }
+
+    /// The lines of the screen, `LineBytes` each, right after each other. Moves when the format is set.
+    [[nodiscard]] const uint8_t *Data() const
+    {
+        return data.data();
+    }
+
+    /// Number of bytes the pixels of a line take in `format`
+    static int LineBytes(PixelFormat format);
+
+    /// Map a line of tagged color indices (see `PaletteTag`) through the BG and OBJ palettes, and store it as line `y`
+    /// \param pixels `Width` tagged color indices
+    void WriteLine(uint8_t y, const uint8_t *pixels, uint8_t bg_palette, uint8_t obj_palette_0, uint8_t obj_palette_1);
+
+    PaletteMapper palette_mapper;
+
+private:
+    PixelFormat format = PixelFormat::RGBA8888;
+    std::vector<uint8_t> data;
+};
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <cstring>
 #include "../HostMemory.h"
 #include "lcd.h"
@@ -25,8 +26,7 @@ void LCD::DrawScanline()
     }
     else
     {
-        uint8_t *dst_ptr = &renderBuffer[current_scanline * BUFFER_WIDTH];
-        memset(dst_ptr, 0, BUFFER_WIDTH);
+        memset(line_buffer, 0, BUFFER_WIDTH);
     }
 
     if (IsFlagSet(LCDCBitmask::OBJ_Enable))
@@ -34,67 +34,56 @@ void LCD::DrawScanline()
         DrawSprites();
     }
 
-    RenderRGBBuffer(current_scanline);
+    memcpy(&renderBuffer[current_scanline * BUFFER_WIDTH], line_buffer, BUFFER_WIDTH);
+    framebuffer.WriteLine(current_scanline, line_buffer, mem.memory[static_cast<uint16_t>(IOAddress::BG_Palette_Data)],
+                          mem.memory[static_cast<uint16_t>(IOAddress::OBJ_Palette_0_Data)],
+                          mem.memory[static_cast<uint16_t>(IOAddress::OBJ_Palette_1_Data)]);
 }
 
-void LCD::DrawSprites()
+void LCD::SortSpritesOntoLines(uint8_t sprite_height)
 {
-    // Sprite attributes reside in the Sprite Attribute Table (OAM - Object Attribute Memory) at $FE00-FE9F.
-
-    // Convert object palettes from the compact format in the two IO registers to two index lists for ease of use
-    uint8_t palette_0[4] = {0};
-    uint8_t palette_1[4] = {0};
-
-    uint8_t palette_bits = mem.memory[(int)IOAddress::OBJ_Palette_0_Data];
-    palette_0[1] = (palette_bits >> 2) & 0b11;
-    palette_0[2] = (palette_bits >> 4) & 0b11;
-    palette_0[3] = (palette_bits >> 6) & 0b11;
-
-    palette_bits = mem.memory[(int)IOAddress::OBJ_Palette_1_Data];
-    palette_1[1] = (palette_bits >> 2) & 0b11;
-    palette_1[2] = (palette_bits >> 4) & 0b11;
-    palette_1[3] = (palette_bits >> 6) & 0b11;
-
-    // Perform OAM scan to determine visible sprites
-
-    OAM_Sprite *spr = reinterpret_cast<OAM_Sprite *>(&mem.memory[OAM_Address]); // NOLINT
-    std::array<OAM_Sprite *, 10> visible_sprites = {NULL};
-    uint8_t number_of_sprites_visible_on_scanline = 0;
+    for (SpriteLine &line : sprite_lines)
+    {
+        line.count = 0;
+    }
 
-    bool sprite_is_visible_on_current_scanline;
+    const OAM_Sprite *sprites = reinterpret_cast<const OAM_Sprite *>(&mem.memory[OAM_Address]); // NOLINT
+    // 8x16 sprites are hidden at Y 0, and 8x8 sprites up to Y 8
+    uint8_t min_y_position = sprite_height == 16 ? 1 : 9;
 
-    if (IsFlagSet(LCDCBitmask::OBJ_Size))
+    for (uint8_t sprIndex = 0; sprIndex < NUMBER_OF_SPRITES; sprIndex++)
     {
-        // 8x16 sprite
-        constexpr uint8_t sprite_height = 16;
-        for (int sprIndex = 0; (sprIndex < NUMBER_OF_SPRITES) && (number_of_sprites_visible_on_scanline < 10); sprIndex++, spr++)
+        if (sprites[sprIndex].y_position < min_y_position)
         {
-            uint8_t ypos = spr->y_position - 16;
-            sprite_is_visible_on_current_scanline = spr->y_position != 0 && ypos <= current_scanline && ypos + sprite_height > current_scanline;
-            if (sprite_is_visible_on_current_scanline)
-            {
-                visible_sprites[number_of_sprites_visible_on_scanline++] = spr;
-            }
+            continue;
         }
-    }
-    else
-    {
-        // 8x8 sprite
-        constexpr uint8_t sprite_height = 8;
-        for (int sprIndex = 0; (sprIndex < NUMBER_OF_SPRITES) && (number_of_sprites_visible_on_scanline < 10); sprIndex++, spr++)
+
+        // Only the first 10 sprites in OAM on a line are drawn on it
+        uint8_t ypos = sprites[sprIndex].y_position - 16;
+        for (int line = ypos; line < ypos + sprite_height && line < First_VBlank_Scanline; line++)
         {
-            uint8_t ypos = spr->y_position - 16;
-            sprite_is_visible_on_current_scanline = spr->y_position > 8 && ypos <= current_scanline && ypos + sprite_height > current_scanline;
-            if (sprite_is_visible_on_current_scanline)
+            SpriteLine &sprite_line = sprite_lines[line];
+            if (sprite_line.count < Max_Sprites_Per_Line)
             {
-                visible_sprites[number_of_sprites_visible_on_scanline++] = spr;
+                sprite_line.sprites[sprite_line.count++] = sprIndex;
             }
         }
     }
 
-    // Sort visible sprites according to X coordinate
-    std::sort(visible_sprites.begin(), visible_sprites.begin() + number_of_sprites_visible_on_scanline, [](OAM_Sprite *spr_a, OAM_Sprite *spr_b)
-              { return spr_a->x_position >= spr_b->x_position; });
+    // Sprites with a lower X, and then a lower index in OAM, are drawn last to end up on top
+    for (SpriteLine &line : sprite_lines)
+    {
+        std::sort(line.sprites, line.sprites + line.count, [sprites](uint8_t a, uint8_t b)
+                  { return sprites[a].x_position != sprites[b].x_position ? sprites[a].x_position > sprites[b].x_position : a > b; });
+    }
+
+    sprite_lines_height = sprite_height;
+    mem.oam_modified = false;
+}
+
+void LCD::DrawSprites()
+{
+    // Sprite attributes reside in the Sprite Attribute Table (OAM - Object Attribute Memory) at $FE00-FE9F.
 
     uint8_t sprite_height = 8;
     bool is_tall_sprites = false;
@@ -105,18 +94,29 @@ void LCD::DrawSprites()
         sprite_height = 16;
     }
 
-    for (int sprIndex = 0; sprIndex < number_of_sprites_visible_on_scanline; sprIndex++)
+    // The OAM scan is done for all lines at once, and only again after OAM was written
+    if (mem.oam_modified || sprite_height != sprite_lines_height)
     {
+        SortSpritesOntoLines(sprite_height);
+    }
+
+    const OAM_Sprite *sprites = reinterpret_cast<const OAM_Sprite *>(&mem.memory[OAM_Address]); // NOLINT
+    const SpriteLine &sprite_line = sprite_lines[current_scanline];
+    if (sprite_line.count == 0)
+    {
+        return;
+    }
 
-        spr = visible_sprites[sprIndex];
+    // Sprites are drawn on a line of their own, from the lowest priority to the highest, and then merged over the background and window
+    compositor.ClearObjects();
+
+    for (int i = 0; i < sprite_line.count; i++)
+    {
+        const OAM_Sprite *spr = &sprites[sprite_line.sprites[i]];
 
-        uint16_t dst_index = current_scanline * BUFFER_WIDTH + (spr->x_position - 8);
-        uint8_t *dst_ptr = &renderBuffer[dst_index];
         uint16_t spr_data_addr = Tile_Data_Block_0;
         uint8_t ypos = spr->y_position - 16;
 
-        // TODO: https://gbdev.io/pandocs/OAM.html#object-priority-and-conflicts
-
         if (is_tall_sprites)
         {
             spr_data_addr += (spr->tile_index & 0b11111110) << 4; // 16 = size of sprite data. In 16 byte height the last bit is ignored (test for this even exists in DMG-ACID2)
@@ -138,100 +138,28 @@ void LCD::DrawSprites()
         }
         spr_data_addr += (spr_line_being_draw << 1); // index 2 bytes into the sprite data for each line offset
 
-        // Palette
-
-        uint8_t *palette;
-
-        if (spr->attributes & (uint8_t)OAM_Sprite_Attributes::Palette_Number)
-        {
-            palette = palette_1;
-        }
-        else
-        {
-            palette = palette_0;
-        }
-
-        // Transform pixels from bitplanes to chunky
+        // Palette, applied with the color index when the line is mapped to RGB
 
-        uint8_t lobits = mem.memory[spr_data_addr++];
-        uint8_t hibits = mem.memory[spr_data_addr];
-
-        // Draw the actual pixels of a sprite line
-
-        for (int x = 0; x < TILE_WIDTH; x++)
-        {
+        uint8_t palette_tag = (spr->attributes & (uint8_t)OAM_Sprite_Attributes::Palette_Number) ? PaletteTag_OBJ1 : PaletteTag_OBJ0;
 
-            uint8_t bit_number; // Only difference between x-flipped and not is the order of the bits we blit here (bit_number)
+        const uint8_t *pixels = tile_cache.GetRow(spr_data_addr, spr->attributes & (uint8_t)OAM_Sprite_Attributes::X_Flip);
 
-            if (spr->attributes & (uint8_t)OAM_Sprite_Attributes::X_Flip)
-            {
-                bit_number = x; // X Flipped
-            }
-            else
-            {
-                bit_number = 7 - x; // Regular
-            }
-
-            uint8_t color = ((lobits >> bit_number) & 1) | (((hibits >> bit_number) & 1) << 1);
-
-            if (color != 0)
-            {
-                if (!(spr->attributes & (uint8_t)OAM_Sprite_Attributes::BG_And_Window_Over_OBJ))
-                {
-                    *dst_ptr = palette[color];
-                }
-                else
-                {
-                    // If "BG & Window over OBJ" is set on the sprite,
-                    // only blit a sprite pixel if no bg or window pixel is at the current location.
-                    if (*dst_ptr == 0)
-                    {
-                        *dst_ptr = palette[color];
-                    }
-                }
-            }
-            dst_ptr++;
-        }
+        compositor.DrawObjectRow(pixels, spr->x_position - 8, palette_tag,
+                                 spr->attributes & (uint8_t)OAM_Sprite_Attributes::BG_And_Window_Over_OBJ);
     }
+
+    compositor.Composite(line_buffer, BUFFER_WIDTH);
 }
 
 void LCD::DrawBackground()
 {
-    // uint8_t scroll_x = mem.memory[(int)IOAddress::Scroll_X];
+    uint8_t scroll_x = mem.memory[(int)IOAddress::Scroll_X];
     uint8_t scroll_y = mem.memory[(int)IOAddress::Scroll_Y];
-    uint8_t line_buffer[256];
-    uint8_t line_x = 0 - mem.memory[(int)IOAddress::Scroll_X];
-    // uint8_t tile_pixel_scroll_x = scroll_x & 0b111; // how many pixels to scroll the line
-    // uint8_t tile_index_scroll_x = scroll_x >> 3; // How many tile map tiles to scroll
-
-    uint16_t bg_tile_map_addr = IsFlagSet(LCDCBitmask::BG_Tile_Map_Area) ? Tile_Map_Block_1 : Tile_Map_Block_0;
-    uint8_t tilemap_y_index = (current_scanline + scroll_y) >> 3;
-    uint8_t tile_y_line = (current_scanline + scroll_y) & 0b111;
-    uint8_t *dst_ptr = &renderBuffer[current_scanline * BUFFER_WIDTH];
-
-    for (uint8_t tilemap_x = 0; tilemap_x < 32; tilemap_x++)
-    {
-        uint16_t index = (tilemap_y_index * Tile_Map_Width) + tilemap_x;
-        uint8_t tile_id = mem.memory[bg_tile_map_addr + index];
-        // Find the tile address, and add offset to the tile line we want to draw
-        uint16_t tile_data_addr = GetTileDataAddr(tile_id) + (tile_y_line << 1);
-
-        uint8_t lobits = mem.memory[tile_data_addr++];
-        uint8_t hibits = mem.memory[tile_data_addr];
-        for (int x = 0; x < TILE_WIDTH; x++)
-        {
-            // TODO: Unroll this X loop. figure out way to do the planar to indexed thing faster.
-            // TODO: maybe just cache these in indexed mode instead? Why transform them every time we draw them?
-            uint8_t bit_number = 7 - x;
-            uint8_t color = ((lobits >> bit_number) & 1) | (((hibits >> bit_number) & 1) << 1);
-            line_buffer[line_x++] = color;
-            //*dst_ptr = color;
-            dst_ptr++;
-        }
-    }
 
-    memcpy(dst_ptr, line_buffer, BUFFER_WIDTH);
+    BackgroundLayer &layer = background_layers[IsFlagSet(LCDCBitmask::BG_Tile_Map_Area) ? 1 : 0];
+    layer.CopyLine(current_scanline + scroll_y, scroll_x, IsFlagSet(LCDCBitmask::BG_And_Window_Tile_Data_Area), line_buffer, BUFFER_WIDTH);
 }
+
 void LCD::DrawWindow()
 {
     uint8_t wx = mem.Read(IOAddress::Window_X_Position);
@@ -251,7 +179,7 @@ void LCD::DrawWindow()
         }
 
         uint16_t window_tile_map_addr = IsFlagSet(LCDCBitmask::Window_Tile_Map_Area) ? Tile_Map_Block_1 : Tile_Map_Block_0;
-        uint8_t *window_dst_ptr = &renderBuffer[current_scanline * BUFFER_WIDTH + wx];
+        uint8_t *window_dst_ptr = &line_buffer[wx];
         uint8_t window_line_to_draw = window_internal_line_counter;
         uint8_t line_in_window_tiles_to_draw = window_line_to_draw & 0b111;
         uint8_t window_tilemap_line_to_draw = (window_line_to_draw >> 3);
@@ -265,17 +193,8 @@ void LCD::DrawWindow()
             // Find the tile address, and add offset to the tile line we want to draw
             uint16_t tile_data_addr = GetTileDataAddr(tile_id) + line_in_window_tiles_to_draw * 2; // *2 because each line is 2 bytes
 
-            uint8_t lobits = mem.memory[tile_data_addr++];
-            uint8_t hibits = mem.memory[tile_data_addr];
-            for (int x = 0; x < TILE_WIDTH; x++)
-            {
-                // TODO: Unroll this X loop. figure out way to do the planar to indexed thing faster.
-                // TODO: maybe just cache these in indexed mode instead? Why transform them every time we draw them?
-                uint8_t bit_number = 7 - x;
-                uint8_t color = ((lobits >> bit_number) & 1) | (((hibits >> bit_number) & 1) << 1);
-                *window_dst_ptr = color;
-                window_dst_ptr++;
-            }
+            memcpy(window_dst_ptr, tile_cache.GetRow(tile_data_addr), TILE_WIDTH);
+            window_dst_ptr += TILE_WIDTH;
             wx += 8;
         }
 
@@ -283,98 +202,119 @@ void LCD::DrawWindow()
     }
 }
 
-void LCD::Step(uint16_t delta_cycles)
+void LCD::Reset()
+{
+    enabled = false;
+    current_scanline = 0;
+    current_mode = LCD_Mode_HBlank;
+    window_internal_line_counter = 0;
+    ly_equals_lyc = false;
+    is_vblank_irq_already_triggered = false;
+    lyc_just_triggered = false;
+}
+
+void LCD::Step()
 {
-    static bool is_hblank_irq_already_triggered_on_this_line = false;
-    static bool is_scanline_irq_flag_just_set = false;
-    // Scanline cycles
-    // Make current_scanline iterate between 0..153 each lasting 456 cycles
+    // Make current_scanline iterate between 0..153 each lasting 456 cycles.
+    // Lines 0..143 go through modes 2, 3 and 0, and a new line starts with mode 2.
 
-    current_scanline_cycles += delta_cycles;
-    if (current_scanline_cycles >= CyclesPerScanline)
+    switch (current_mode)
     {
-        current_scanline_cycles -= CyclesPerScanline;
+    case LCD_Mode_Searching_OAM:
+        EnterMode(LCD_Mode_Reading_OAM);
+        break;
+    case LCD_Mode_Reading_OAM:
+        EnterMode(LCD_Mode_HBlank);
+        break;
+    case LCD_Mode_HBlank:
         current_scanline++;
-
-        // Trigger VBlank IRQ on line 144
-
-        if (current_scanline == 144)
+        if (current_scanline == First_VBlank_Scanline)
         {
-            if (!is_scanline_irq_flag_just_set)
-            {
-                mem.SetInterruptFlag(Interrupt_Flag_VBlank, true);
-                is_scanline_irq_flag_just_set = true;
-            }
+            frame_count++;
+            mem.SetInterruptFlag(Interrupt_Flag_VBlank, true);
+            EnterMode(LCD_Mode_VBlank);
         }
         else
         {
-            is_scanline_irq_flag_just_set = false;
+            EnterMode(LCD_Mode_Searching_OAM);
         }
-
-        if (current_scanline == 154)
+        break;
+    case LCD_Mode_VBlank:
+        // VBlank lasts for lines 144..153
+        current_scanline++;
+        if (current_scanline == Number_Of_Scanlines)
         {
             current_scanline = 0;
             window_internal_line_counter = 0;
+            StartFrame();
+            EnterMode(LCD_Mode_Searching_OAM);
         }
-
-        draw_scanline = true;
+        break;
     }
 
-    mem[LCD_Y_Register] = current_scanline;
-
-    accumulated_cycles += delta_cycles;
+    CheckStatInterrupts();
+}
 
-    // If enough cycles has passed: switch to next mode
+void LCD::EnterMode(LCD_Modes mode)
+{
+    current_mode = mode;
 
-    if (accumulated_cycles >= LCD_Mode_Cycles[LCD_Mode_Order[current_mode_index]])
+    switch (mode)
     {
-        accumulated_cycles -= LCD_Mode_Cycles[LCD_Mode_Order[current_mode_index]];
-        current_mode_index++;
-
-        if (current_mode_index == 4)
-        { // VBlank is done, restart mode order
-            current_mode_index = 0;
-        }
-
-        if (current_scanline < 144 && LCD_Mode_Order[current_mode_index] == LCD_Mode_VBlank)
-        {
-            current_mode_index = 0;
-        }
-
-        if (LCD_Mode_Order[current_mode_index] == LCD_Mode_Searching_OAM)
+    case LCD_Mode_Searching_OAM:
+        if (mem[LCD_Stat_Register] & LCD_Stat_IRQ_From_OAM)
         {
-            if (mem[LCD_Stat_Register] & LCD_Stat_IRQ_From_OAM)
-            {
-                mem.SetInterruptFlag(Interrupt_Flag_LCD_Stat, true);
-            }
+            mem.SetInterruptFlag(Interrupt_Flag_LCD_Stat, true);
         }
-
-        if (LCD_Mode_Order[current_mode_index] == LCD_Mode_Reading_OAM)
+        break;
+    case LCD_Mode_Reading_OAM:
+        if (drawing_frame)
         {
             DrawScanline();
         }
-
-        if (LCD_Mode_Order[current_mode_index] == LCD_Mode_HBlank)
+        break;
+    case LCD_Mode_HBlank:
+        if (mem[LCD_Stat_Register] & LCD_Stat_IRQ_From_HBlank)
         {
-            if (mem[LCD_Stat_Register] & LCD_Stat_IRQ_From_HBlank)
-            {
-                if (!is_hblank_irq_already_triggered_on_this_line)
-                {
-                    mem.SetInterruptFlag(Interrupt_Flag_LCD_Stat, true);
-                    is_hblank_irq_already_triggered_on_this_line = true;
-                }
-            }
+            mem.SetInterruptFlag(Interrupt_Flag_LCD_Stat, true);
         }
-        else
+        break;
+    case LCD_Mode_VBlank:
+        break;
+    }
+}
+
+void LCD::StartFrame()
+{
+    // A period of 0 is taken as 1 rather than dividing by it
+    drawing_frame = !skip_next_frame && frame_count % std::max<uint32_t>(frame_skip_period, 1) < frames_drawn_per_period;
+    skip_next_frame = false;
+}
+
+void LCD::RegistersWritten()
+{
+    bool lcd_enabled = mem[LCD_Control_Register] & static_cast<uint8_t>(LCDCBitmask::LCD_enabled);
+    if (lcd_enabled != enabled)
+    {
+        // LY stays at 0 while the LCD is off, and it starts over from the first line when turned back on
+        Reset();
+        enabled = lcd_enabled;
+        if (enabled)
         {
-            is_hblank_irq_already_triggered_on_this_line = false;
+            StartFrame();
+            current_mode = LCD_Mode_Searching_OAM;
         }
     }
 
-    // bool to make sure vblank interrupt is only triggered once in LCD_Mode_VBlank (mode 1)
-    static bool is_vblank_irq_already_triggered = false;
+    if (enabled)
+    {
+        CheckStatInterrupts();
+    }
+}
 
-    if (LCD_Mode_Order[current_mode_index] == LCD_Mode_VBlank)
+void LCD::CheckStatInterrupts()
+{
+    if (current_mode == LCD_Mode_VBlank)
     {
         if (mem[LCD_Stat_Register] & LCD_Stat_IRQ_From_VBlank)
         {
@@ -390,14 +330,10 @@ void LCD::Step(uint16_t delta_cycles)
         is_vblank_irq_already_triggered = false;
     }
 
-    mem[LCD_Stat_Register] &= 0b11111100;                         // Clear mode bits
-    mem[LCD_Stat_Register] |= LCD_Mode_Order[current_mode_index]; // Set the current mode bits
-
     // LY Compare
 
-    static bool lyc_just_triggered = false;
-
-    if (mem[LCD_Y_Register] == mem[LCD_Y_Compare_Register])
+    ly_equals_lyc = current_scanline == mem[LCD_Y_Compare_Register];
+    if (ly_equals_lyc)
     {
         // Trigger Stat IRQ from LYC (if enabled in the stat register)
         if ((mem[LCD_Stat_Register] & LCD_Stat_IRQ_From_LYC) && !lyc_just_triggered)
@@ -405,36 +341,21 @@ void LCD::Step(uint16_t delta_cycles)
             mem.SetInterruptFlag(Interrupt_Flag_LCD_Stat, true);
             lyc_just_triggered = true;
         }
-        mem[LCD_Stat_Register] |= LCD_Stat_LY_EQ_LYC;
     }
     else
     {
-        mem[LCD_Stat_Register] &= ~LCD_Stat_LY_EQ_LYC;
         lyc_just_triggered = false;
     }
 }
 
-void LCD::RenderRGBBuffer(uint8_t line_number)
+uint8_t LCD::ReadStatRegister() const
 {
-    // $00, $55, $AA, $FF.
-    constexpr RGB paletteColors[4] = {{0xff, 0xff, 0xff}, {0xaa, 0xaa, 0xaa}, {0x55, 0x55, 0x55}, {0, 0, 00}};
-    RGB rgb[4] = {};
-
-    uint8_t paletteMapping = mem.memory[static_cast<uint16_t>(IOAddress::BG_Palette_Data)];
-
-    // Map colors according to the BG palette register
-    rgb[0] = paletteColors[paletteMapping & 0b11];
-    rgb[1] = paletteColors[(paletteMapping >> 2) & 0b11];
-    rgb[2] = paletteColors[(paletteMapping >> 4) & 0b11];
-    rgb[3] = paletteColors[(paletteMapping >> 6) & 0b11];
-
-    uint16_t offset = line_number * BUFFER_WIDTH;
-    uint32_t *dst_ptr = reinterpret_cast<uint32_t *>(&rgbBuffer[offset]); // NOLINT
-    for (int i = offset; i < offset + BUFFER_WIDTH; i++)
+    uint8_t stat = mem.memory[LCD_Stat_Register] & ~(LCD_Stat_LY_EQ_LYC | 0b11);
+    if (ly_equals_lyc)
     {
-        uint8_t colorIndex = renderBuffer[i];
-        *dst_ptr++ = rgb[colorIndex].RGBA;
+        stat |= LCD_Stat_LY_EQ_LYC;
     }
+    return stat | current_mode;
 }
 
 /// Get the address of a tiles data based on tile id and the current LCD_Control_Register control bits
@@ -456,8 +377,8 @@ uint16_t LCD::GetTileDataAddr(uint8_t tile_id)
 
 /// Render a tile from GB memory to an internal renderBuffer, and translate the GB 2BPP format to an index color.
 /// \param tile_data_addr Address in GB memory where tile data for this tile is located
-/// \param dst_x Destination X on screen (0-255)
-/// \param dst_y Destination Y on screen (0-255)
+/// \param dst_x Destination X on screen (0-152)
+/// \param dst_y Destination Y on screen (0-136)
 void LCD::DrawTile(uint16_t tile_data_addr, uint8_t dst_x, uint8_t dst_y)
 {
 
@@ -465,19 +386,8 @@ void LCD::DrawTile(uint16_t tile_data_addr, uint8_t dst_x, uint8_t dst_y)
 
     for (int y = 0; y < TILE_HEIGHT; y++)
     {
-        uint8_t lobits = mem.memory[tile_data_addr++]; // mem.Read(tile_data_addr++);
-        uint8_t hibits = mem.memory[tile_data_addr++];
-        for (int x = 0; x < TILE_WIDTH; x++)
-        {
-            // TODO: Unroll this X loop. figure out way to do the planar to indexed thing faster.
-            // TODO: maybe just cache these in indexed mode instead? Why transform them every time we draw them?
-            uint8_t bit_number = 7 - x;
-            uint8_t color = ((lobits >> bit_number) & 1) | (((hibits >> bit_number) & 1) << 1);
-            *dst_ptr = color;
-            dst_ptr++;
-            // renderBuffer[(dst_y+y) * BUFFER_WIDTH + (dst_x+x)] = color;
-        }
-
-        dst_ptr += BUFFER_WIDTH - TILE_WIDTH;
+        memcpy(dst_ptr, tile_cache.GetRow(tile_data_addr), TILE_WIDTH);
+        tile_data_addr += 2;
+        dst_ptr += BUFFER_WIDTH;
     }
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 
 #include <cstring>
 #include "../HostMemory.h"
+#include "background_layer.h"
+#include "framebuffer.h"
+#include "scanline_compositor.h"
+#include "tile_cache.h"
 
 enum class LCDCBitmask: uint8_t {
     LCD_enabled = 1 << 7,                  // 7	LCD and PPU enable	0=Off, 1=On
@@ -36,18 +40,6 @@ private:
     static constexpr uint16_t Tile_Data_Block_2 = 0x9000;
     static constexpr uint16_t OAM_Address = 0xfe00;
 
-    struct RGB {
-        union {
-            struct {
-                uint8_t R = 0;
-                uint8_t G = 0;
-                uint8_t B = 0;
-                uint8_t A = 0xff;
-            };
-            uint32_t RGBA;
-        };
-    };
-
     struct OAM_Sprite {
         uint8_t y_position;
         uint8_t x_position;
@@ -67,7 +59,14 @@ private:
     };
 
     static constexpr uint16_t LCD_Mode_Cycles[] = { 208, 4560, 80,  168 };
-    static constexpr uint8_t LCD_Mode_Order[] = { LCD_Mode_Searching_OAM,LCD_Mode_Reading_OAM,LCD_Mode_HBlank,LCD_Mode_VBlank };
+    static constexpr uint8_t First_VBlank_Scanline = 144;
+    static constexpr uint8_t Max_Sprites_Per_Line = 10;
+
+    /// Indices in OAM of the sprites on a line, in the order they are drawn. The last one drawn ends up on top.
+    struct SpriteLine {
+        uint8_t count = 0;
+        uint8_t sprites[Max_Sprites_Per_Line] = {};
+    };
 
     // On scanlines 0 through 143, the PPU cycles through modes 2, 3, and 0 once every 456 dots. Scanlines 144 through 153 are mode 1.
     // Mode 2  2_____2_____2_____2_____2_____2___________________2____
@@ -113,34 +112,64 @@ public:
     /// LCD Y Compare register - triggers a stat irq if stat bit 2 is set and Y == YC
     static constexpr uint16_t LCD_Y_Compare_Register = 0xff45;
 
-    static constexpr int BUFFER_WIDTH = 256;
-    static constexpr int BUFFER_HEIGHT = 256;
+    static constexpr int BUFFER_WIDTH = Framebuffer::Width;
+    static constexpr int BUFFER_HEIGHT = Framebuffer::Height;
     static constexpr int NUMBER_OF_SPRITES = 40;
     static constexpr int Tile_Map_Width = 32;
 
-    /// A index-color based render buffer. Every time `Step` is called all tiles and sprites are rendered to this buffer based on OAM, tile maps and tile data.
-    /// Each byte represents an index color between 0-3.
-    /// It is up to the implementer to actually draw this to screen and map it to actual RGB values.
+    /// A index-color based render buffer of the visible screen. Every time a scanline is drawn, its tiles and sprites are rendered to this buffer based on OAM, tile maps and tile data.
+    /// Each byte represents an index color between 0-3, with the palette it is drawn with in bits 2-3 (see `PaletteTag`).
     uint8_t renderBuffer[BUFFER_WIDTH * BUFFER_HEIGHT] = {};
-    RGB rgbBuffer[BUFFER_WIDTH * BUFFER_HEIGHT] = {};
-
-    uint8_t& current_scanline;
-    bool draw_scanline = true;
-    uint8_t current_mode_index = 0;
-    uint16_t accumulated_cycles = 0;
+    /// The lines drawn, mapped to colors in the pixel format the frontend asked for
+    Framebuffer framebuffer;
+
+    /// LY, the scanline being drawn (0-153). 0 while the LCD is off.
+    uint8_t current_scanline = 0;
+    /// Number of frames drawn, counted when the LCD enters VBlank
+    uint64_t frame_count = 0;
+
+    /// Frame skipping, for fast-forward and runs nobody watches: of every `frame_skip_period` frames only the first `frames_drawn_per_period` are drawn.
+    /// Skipped frames have the same timing, STAT changes and interrupts, but none of their lines are drawn,
+    /// so `renderBuffer` and `framebuffer` keep the last frame that was.
+    uint32_t frames_drawn_per_period = 1;
+    /// 0 is treated as 1
+    uint32_t frame_skip_period = 1;
+    /// Skip drawing the next frame whatever the frame skipping above says. Cleared when that frame starts.
+    bool skip_next_frame = false;
 
     static constexpr uint16_t CyclesPerScanline = 456;
-    uint16_t current_scanline_cycles = 0;
 
-    explicit LCD( HostMemory& mem ) : mem(mem), current_scanline(mem[LCD_Y_Register])
+    explicit LCD( HostMemory& mem ) : mem(mem), tile_cache(mem),
+        background_layers{BackgroundLayer(mem, tile_cache, Tile_Map_Block_0), BackgroundLayer(mem, tile_cache, Tile_Map_Block_1)}
     {
     };
 
     LCD() = delete;
 
-    void Step( uint16_t delta_cycles );
+    /// Turn the LCD off, as it is until LCDC enables it
+    void Reset();
+
+    /// Move on to the next mode or scanline, `CyclesUntilNextEvent` cycles after the last one.
+    /// Nothing the CPU can observe changes in between, so the LCD is only stepped at these events.
+    void Step();
+
+    /// Number of cycles the current mode, or scanline in VBlank, lasts. Only meaningful while the LCD is on.
+    [[nodiscard]] uint16_t CyclesUntilNextEvent() const
+    {
+        return current_mode == LCD_Mode_VBlank ? CyclesPerScanline : LCD_Mode_Cycles[current_mode];
+    }
+
+    /// Apply writes to LCDC, STAT and LYC: turn the LCD on or off, and request the STAT interrupts they enable.
+    void RegistersWritten();
 
-    void RenderRGBBuffer( uint8_t line_number );
+    /// Whether the LCD is running, as last enabled by LCDC
+    [[nodiscard]] bool IsEnabled() const
+    {
+        return enabled;
+    }
+
+    /// Value of the STAT register: the interrupt sources last written, with the current mode and LY=LYC flag
+    [[nodiscard]] uint8_t ReadStatRegister() const;
 
     inline bool IsFlagSet(LCDCBitmask flag)
     {
@@ -162,13 +191,45 @@ public:
 
     /// Render a tile from GB memory to an internal renderBuffer, and translate the GB 2BPP format to an index color.
     /// \param tile_data_addr Address in GB memory where tile data for this tile is located
-    /// \param dst_x Destination X on screen (0-255)
-    /// \param dst_y Destination Y on screen (0-255)
+    /// \param dst_x Destination X on screen (0-152)
+    /// \param dst_y Destination Y on screen (0-136)
     void DrawTile( uint16_t tile_data_addr, uint8_t dst_x, uint8_t dst_y );
 
 private:
 
+    /// Tile data decoded to color indices, which the scanline is drawn from
+    TileCache tile_cache;
+    /// The two tile maps drawn as backgrounds, which lines are copied from at the scroll position
+    BackgroundLayer background_layers[2];
+    /// Merges the sprites of a line over its background and window
+    ScanlineCompositor compositor;
+    /// The scanline being drawn, with room for the tiles and sprites drawn past the right edge of the screen
+    uint8_t line_buffer[ScanlineCompositor::LineWidth] = {};
+
+    /// Sprites on each visible line, sorted again when OAM or the sprite size changed
+    std::array<SpriteLine, First_VBlank_Scanline> sprite_lines{};
+    /// Sprite height `sprite_lines` were sorted with
+    uint8_t sprite_lines_height = 0;
+
     uint8_t window_internal_line_counter = 0;
+    bool enabled = false;
+    /// Whether the lines of the current frame are drawn, decided when it starts
+    bool drawing_frame = true;
+    LCD_Modes current_mode = LCD_Mode_HBlank;
+    /// LY=LYC flag of the STAT register, as of the last step
+    bool ly_equals_lyc = false;
+
+    // These STAT interrupts can also be enabled in the middle of VBlank or a scanline, and must still only be requested once in it
+    bool is_vblank_irq_already_triggered = false;
+    bool lyc_just_triggered = false;
+
+    void EnterMode(LCD_Modes mode);
+
+    /// Decide whether the frame starting at line 0 is drawn
+    void StartFrame();
+
+    /// Request the STAT interrupts from VBlank and LY=LYC, if they are enabled and weren't requested yet
+    void CheckStatInterrupts();
 
     void DrawWindow();
 
@@ -177,4 +238,7 @@ private:
     void DrawScanline();
 
     void DrawSprites();
+
+    /// Perform the OAM scan for all lines: find the sprites on every line, and sort them into the order they are drawn in
+    void SortSpritesOntoLines(uint8_t sprite_height);
 };
\ No newline at end of file
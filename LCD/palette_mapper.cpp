@@ -0,0 +1,199 @@
+#include "palette_mapper.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MEGABOY_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    template <int BytesPerPixel>
+    void MapPortable(const std::array<uint32_t, 16> &colors, const uint8_t *pixels, uint8_t *dst, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            uint32_t color = colors[pixels[i] & 0xf];
+            for (int byte = 0; byte < BytesPerPixel; byte++)
+            {
+                dst[i * BytesPerPixel + byte] = color >> (byte * 8);
+            }
+        }
+    }
+
+#ifdef MEGABOY_X86_SIMD
+    /// Split the colors into a table per byte, which the shuffles look up the bytes of the pixels in
+    void SplitChannels(const std::array<uint32_t, 16> &colors, uint8_t (&tables)[4][16])
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            for (int channel = 0; channel < 4; channel++)
+            {
+                tables[channel][i] = colors[i] >> (channel * 8);
+            }
+        }
+    }
+
+    template <int BytesPerPixel>
+    __attribute__((target("ssse3"))) void MapSSSE3(const std::array<uint32_t, 16> &colors, const uint8_t *pixels, uint8_t *dst, int count)
+    {
+        alignas(16) uint8_t tables[4][16];
+        SplitChannels(colors, tables);
+        const __m128i r_table = _mm_load_si128(reinterpret_cast<const __m128i *>(tables[0]));
+        const __m128i g_table = _mm_load_si128(reinterpret_cast<const __m128i *>(tables[1]));
+        const __m128i b_table = _mm_load_si128(reinterpret_cast<const __m128i *>(tables[2]));
+        const __m128i a_table = _mm_load_si128(reinterpret_cast<const __m128i *>(tables[3]));
+        const __m128i index_mask = _mm_set1_epi8(0xf);
+
+        for (int i = 0; i < count; i += 16)
+        {
+            __m128i indices = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&pixels[i])), index_mask);
+            auto *out = reinterpret_cast<__m128i *>(&dst[i * BytesPerPixel]);
+            __m128i r = _mm_shuffle_epi8(r_table, indices);
+            if constexpr (BytesPerPixel == 1)
+            {
+                _mm_storeu_si128(out, r);
+                continue;
+            }
+
+            // Interleave the bytes back to whole colors
+            __m128i g = _mm_shuffle_epi8(g_table, indices);
+            __m128i rg_low = _mm_unpacklo_epi8(r, g);
+            __m128i rg_high = _mm_unpackhi_epi8(r, g);
+            if constexpr (BytesPerPixel == 2)
+            {
+                _mm_storeu_si128(out, rg_low);
+                _mm_storeu_si128(out + 1, rg_high);
+                continue;
+            }
+
+            __m128i b = _mm_shuffle_epi8(b_table, indices);
+            __m128i a = _mm_shuffle_epi8(a_table, indices);
+            __m128i ba_low = _mm_unpacklo_epi8(b, a);
+            __m128i ba_high = _mm_unpackhi_epi8(b, a);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(rg_low, ba_low));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rg_low, ba_low));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rg_high, ba_high));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rg_high, ba_high));
+        }
+    }
+
+    template <int BytesPerPixel>
+    __attribute__((target("avx2"))) void MapAVX2(const std::array<uint32_t, 16> &colors, const uint8_t *pixels, uint8_t *dst, int count)
+    {
+        alignas(16) uint8_t tables[4][16];
+        SplitChannels(colors, tables);
+        // The shuffle looks up within each 128 bit lane, so both lanes hold the whole table
+        const __m256i r_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(tables[0])));
+        const __m256i g_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(tables[1])));
+        const __m256i b_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(tables[2])));
+        const __m256i a_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(tables[3])));
+        const __m256i index_mask = _mm256_set1_epi8(0xf);
+
+        for (int i = 0; i < count; i += 32)
+        {
+            __m256i indices = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&pixels[i])), index_mask);
+            auto *out = reinterpret_cast<__m256i *>(&dst[i * BytesPerPixel]);
+            __m256i r = _mm256_shuffle_epi8(r_table, indices);
+            if constexpr (BytesPerPixel == 1)
+            {
+                _mm256_storeu_si256(out, r);
+                continue;
+            }
+
+            // Interleaving works within lanes too: the low lane ends up with pixels 0-15 and the high lane with 16-31
+            __m256i g = _mm256_shuffle_epi8(g_table, indices);
+            __m256i rg_low = _mm256_unpacklo_epi8(r, g);
+            __m256i rg_high = _mm256_unpackhi_epi8(r, g);
+            if constexpr (BytesPerPixel == 2)
+            {
+                _mm256_storeu_si256(out, _mm256_permute2x128_si256(rg_low, rg_high, 0x20));
+                _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(rg_low, rg_high, 0x31));
+                continue;
+            }
+
+            __m256i b = _mm256_shuffle_epi8(b_table, indices);
+            __m256i a = _mm256_shuffle_epi8(a_table, indices);
+            __m256i ba_low = _mm256_unpacklo_epi8(b, a);
+            __m256i ba_high = _mm256_unpackhi_epi8(b, a);
+            __m256i pixels_0_3 = _mm256_unpacklo_epi16(rg_low, ba_low);
+            __m256i pixels_4_7 = _mm256_unpackhi_epi16(rg_low, ba_low);
+            __m256i pixels_8_11 = _mm256_unpacklo_epi16(rg_high, ba_high);
+            __m256i pixels_12_15 = _mm256_unpackhi_epi16(rg_high, ba_high);
+
+            _mm256_storeu_si256(out, _mm256_permute2x128_si256(pixels_0_3, pixels_4_7, 0x20));
+            _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(pixels_8_11, pixels_12_15, 0x20));
+            _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(pixels_0_3, pixels_4_7, 0x31));
+            _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(pixels_8_11, pixels_12_15, 0x31));
+        }
+    }
+#endif
+
+    using MapFunction = void (*)(const std::array<uint32_t, 16> &, const uint8_t *, uint8_t *, int);
+
+    /// The instance of a kernel for 1, 2 or 4 bytes per pixel
+    MapFunction Select(MapFunction one, MapFunction two, MapFunction four, int bytes_per_pixel)
+    {
+        return bytes_per_pixel == 1 ? one : bytes_per_pixel == 2 ? two : four;
+    }
+}
+
+bool PaletteMapper::IsSupported(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Portable:
+        return true;
+#ifdef MEGABOY_X86_SIMD
+    case Kernel::SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case Kernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+PaletteMapper::Kernel PaletteMapper::FastestKernel()
+{
+    for (Kernel kernel : {Kernel::AVX2, Kernel::SSSE3})
+    {
+        if (IsSupported(kernel))
+        {
+            return kernel;
+        }
+    }
+    return Kernel::Portable;
+}
+
+void PaletteMapper::SetPalettes(uint8_t bg_palette, uint8_t obj_palette_0, uint8_t obj_palette_1, const std::array<uint32_t, 4> &shades)
+{
+    const uint8_t palettes[3] = {bg_palette, obj_palette_0, obj_palette_1};
+    for (int palette = 0; palette < 3; palette++)
+    {
+        for (int color = 0; color < 4; color++)
+        {
+            colors[palette * 4 + color] = shades[(palettes[palette] >> (color * 2)) & 0b11];
+        }
+    }
+}
+
+void PaletteMapper::Map(Kernel kernel, const std::array<uint32_t, 16> &colors, int bytes_per_pixel, const uint8_t *pixels, uint8_t *dst, int count)
+{
+    MapFunction map;
+    switch (kernel)
+    {
+#ifdef MEGABOY_X86_SIMD
+    case Kernel::SSSE3:
+        map = Select(MapSSSE3<1>, MapSSSE3<2>, MapSSSE3<4>, bytes_per_pixel);
+        break;
+    case Kernel::AVX2:
+        map = Select(MapAVX2<1>, MapAVX2<2>, MapAVX2<4>, bytes_per_pixel);
+        break;
+#endif
+    default:
+        map = Select(MapPortable<1>, MapPortable<2>, MapPortable<4>, bytes_per_pixel);
+        break;
+    }
+    map(colors, pixels, dst, count);
+}
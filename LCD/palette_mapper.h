@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/// Palette a pixel of `LCD::renderBuffer` is drawn with, stored in bits 2-3 above its color index
+enum PaletteTag : uint8_t
+{
+    PaletteTag_BG = 0,
+    PaletteTag_OBJ0 = 1 << 2,
+    PaletteTag_OBJ1 = 2 << 2,
+};
+
+/// Maps color indices tagged with their palette (see `PaletteTag`) through BGP, OBP0 and OBP1 to colors of 1, 2 or 4 bytes.
+///
+/// The 3 palettes of 4 colors fit a 16 entry table, so the SIMD kernels look up 16 or 32 pixels at once with byte shuffles,
+/// one shuffle per byte of the color.
+class PaletteMapper
+{
+public:
+    /// Implementations of `Map`, which all give the same result
+    enum class Kernel : uint8_t
+    {
+        /// One table lookup per pixel
+        Portable,
+        /// 16 pixels per PSHUFB
+        SSSE3,
+        /// 32 pixels per VPSHUFB
+        AVX2
+    };
+
+    /// Number of pixels each call to `Map` must be a multiple of
+    static constexpr int PixelGranularity = 32;
+
+    /// Whether the CPU running the emulator supports `kernel`
+    static bool IsSupported(Kernel kernel);
+
+    /// The fastest kernel the CPU supports
+    static Kernel FastestKernel();
+
+    /// The 4 shades of gray of the DMG from white to black, as RGBA with R in the lowest byte
+    static constexpr std::array<uint32_t, 4> RGBAShades = {0xffffffff, 0xffaaaaaa, 0xff555555, 0xff000000};
+
+    Kernel kernel = FastestKernel();
+
+    /// Set the colors from the BG and OBJ palette registers
+    /// \param shades the color each of the 4 shades of gray is mapped to
+    void SetPalettes(uint8_t bg_palette, uint8_t obj_palette_0, uint8_t obj_palette_1, const std::array<uint32_t, 4> &shades = RGBAShades);
+
+    /// Map tagged pixels to the lowest `bytes_per_pixel` bytes of their colors (1, 2 or 4), stored lowest byte first
+    /// \param count number of pixels, a multiple of `PixelGranularity`
+    void Map(const uint8_t *pixels, uint8_t *dst, int bytes_per_pixel, int count) const
+    {
+        Map(kernel, colors, bytes_per_pixel, pixels, dst, count);
+    }
+
+    static void Map(Kernel kernel, const std::array<uint32_t, 16> &colors, int bytes_per_pixel, const uint8_t *pixels, uint8_t *dst, int count);
+
+    /// Colors of tagged pixels, indexed by the tag and color index
+    std::array<uint32_t, 16> colors{};
+};
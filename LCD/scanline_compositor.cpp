@@ -0,0 +1,141 @@
+#include <cstring>
+#include <initializer_list>
+#include "scanline_compositor.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MEGABOY_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr uint64_t LowBitOfEachByte = 0x0101010101010101;
+
+    /// 0xff in every byte that isn't 0, for bytes below 0x80
+    inline uint64_t NonZeroBytes(uint64_t bytes)
+    {
+        return (((bytes + 0x7f7f7f7f7f7f7f7f) >> 7) & LowBitOfEachByte) * 0xff;
+    }
+
+    void CompositePortable(uint8_t *line, const uint8_t *objects, const uint8_t *behind_bg, int count)
+    {
+        for (int i = 0; i < count; i += 8)
+        {
+            uint64_t bg;
+            uint64_t obj;
+            uint64_t behind;
+            memcpy(&bg, &line[i], sizeof(bg));
+            memcpy(&obj, &objects[i], sizeof(obj));
+            memcpy(&behind, &behind_bg[i], sizeof(behind));
+
+            uint64_t show_obj = NonZeroBytes(obj) & ~(behind & NonZeroBytes(bg));
+            bg = (bg & ~show_obj) | (obj & show_obj);
+            memcpy(&line[i], &bg, sizeof(bg));
+        }
+    }
+
+#ifdef MEGABOY_X86_SIMD
+    void CompositeSSE2(uint8_t *line, const uint8_t *objects, const uint8_t *behind_bg, int count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        for (int i = 0; i < count; i += 16)
+        {
+            __m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&line[i]));
+            __m128i obj = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&objects[i]));
+            __m128i behind = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&behind_bg[i]));
+
+            // Hidden where there is no sprite, or the sprite is behind a BG color 1-3
+            __m128i hide_obj = _mm_or_si128(_mm_cmpeq_epi8(obj, zero), _mm_andnot_si128(_mm_cmpeq_epi8(bg, zero), behind));
+            bg = _mm_or_si128(_mm_and_si128(hide_obj, bg), _mm_andnot_si128(hide_obj, obj));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&line[i]), bg);
+        }
+    }
+
+    __attribute__((target("avx2"))) void CompositeAVX2(uint8_t *line, const uint8_t *objects, const uint8_t *behind_bg, int count)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (int i = 0; i < count; i += 32)
+        {
+            __m256i bg = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&line[i]));
+            __m256i obj = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&objects[i]));
+            __m256i behind = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&behind_bg[i]));
+
+            __m256i hide_obj = _mm256_or_si256(_mm256_cmpeq_epi8(obj, zero), _mm256_andnot_si256(_mm256_cmpeq_epi8(bg, zero), behind));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(&line[i]), _mm256_blendv_epi8(obj, bg, hide_obj));
+        }
+    }
+#endif
+}
+
+bool ScanlineCompositor::IsSupported(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Portable:
+        return true;
+#ifdef MEGABOY_X86_SIMD
+    case Kernel::SSE2:
+        return true;
+    case Kernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+ScanlineCompositor::Kernel ScanlineCompositor::FastestKernel()
+{
+    for (Kernel kernel : {Kernel::AVX2, Kernel::SSE2})
+    {
+        if (IsSupported(kernel))
+        {
+            return kernel;
+        }
+    }
+    return Kernel::Portable;
+}
+
+void ScanlineCompositor::ClearObjects()
+{
+    memset(objects, 0, sizeof(objects));
+    memset(behind_bg, 0, sizeof(behind_bg));
+}
+
+void ScanlineCompositor::DrawObjectRow(const uint8_t *pixels, int x, uint8_t palette_tag, bool behind_background)
+{
+    uint64_t row;
+    memcpy(&row, pixels, sizeof(row));
+    // Color indices are 0-3, so a pixel is opaque if either of its two low bits is set
+    uint64_t opaque = ((row | (row >> 1)) & LowBitOfEachByte) * 0xff;
+
+    uint64_t obj;
+    uint64_t behind;
+    memcpy(&obj, &objects[Padding + x], sizeof(obj));
+    memcpy(&behind, &behind_bg[Padding + x], sizeof(behind));
+
+    obj = (obj & ~opaque) | ((row | palette_tag * LowBitOfEachByte) & opaque);
+    behind = (behind & ~opaque) | (behind_background ? opaque : 0);
+    memcpy(&objects[Padding + x], &obj, sizeof(obj));
+    memcpy(&behind_bg[Padding + x], &behind, sizeof(behind));
+}
+
+void ScanlineCompositor::Composite(Kernel kernel, uint8_t *line, const uint8_t *objects, const uint8_t *behind_bg, int count)
+{
+    switch (kernel)
+    {
+#ifdef MEGABOY_X86_SIMD
+    case Kernel::SSE2:
+        CompositeSSE2(line, objects, behind_bg, count);
+        break;
+    case Kernel::AVX2:
+        CompositeAVX2(line, objects, behind_bg, count);
+        break;
+#endif
+    default:
+        CompositePortable(line, objects, behind_bg, count);
+        break;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+/// Merges the sprites of a line over its background and window.
+///
+/// Sprite rows are drawn on a line of their own from the lowest to the highest priority, so every pixel ends up with the sprite that wins
+/// it over the others, along with whether that sprite is behind BG and window colors 1-3. The line is then merged over the background and
+/// window in one pass, many pixels at a time.
+class ScanlineCompositor
+{
+public:
+    static constexpr int LineWidth = 256;
+
+    /// Implementations of `Composite`, which all give the same result
+    enum class Kernel : uint8_t
+    {
+        /// 8 pixels at a time in a 64 bit integer
+        Portable,
+        /// 16 pixels per SSE2 blend
+        SSE2,
+        /// 32 pixels per AVX2 blend
+        AVX2
+    };
+
+    /// Whether the CPU running the emulator supports `kernel`
+    static bool IsSupported(Kernel kernel);
+
+    /// The fastest kernel the CPU supports
+    static Kernel FastestKernel();
+
+    Kernel kernel = FastestKernel();
+
+    /// Clear the sprites of the last line
+    void ClearObjects();
+
+    /// Draw a row of a sprite over the sprites drawn before it on the line. Color 0 is transparent.
+    /// \param pixels the 8 color indices of the row, left to right as drawn
+    /// \param x position on the line of the leftmost pixel (-8 to 248)
+    /// \param palette_tag `PaletteTag` of the OBJ palette the sprite uses
+    /// \param behind_background whether BG and window colors 1-3 are drawn over the sprite
+    void DrawObjectRow(const uint8_t *pixels, int x, uint8_t palette_tag, bool behind_background);
+
+    /// Merge the sprites drawn over a line of background and window pixels
+    /// \param count number of pixels from the left, a multiple of 32
+    void Composite(uint8_t *line, int count = LineWidth) const
+    {
+        Composite(kernel, line, &objects[Padding], &behind_bg[Padding], count);
+    }
+
+    /// \param count number of pixels, a multiple of 32
+    static void Composite(Kernel kernel, uint8_t *line, const uint8_t *objects, const uint8_t *behind_bg, int count);
+
+private:
+    /// Room for sprites partially left of the line
+    static constexpr int Padding = 8;
+
+    /// Sprite pixels with their palette tag, 0 where no sprite is
+    uint8_t objects[Padding + LineWidth] = {};
+    /// 0xff where the sprite pixel is behind BG and window colors 1-3
+    uint8_t behind_bg[Padding + LineWidth] = {};
+};
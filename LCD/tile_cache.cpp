@@ -0,0 +1,163 @@
+#include <cstring>
+#include "tile_cache.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MEGABOY_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /// Selects bit 7 - i of a byte repeated in every byte i, so the leftmost pixel ends up in the first byte
+    constexpr uint64_t PixelBitMask = 0x0102040810204080;
+    /// Selects bit i of a byte repeated in every byte i, for the mirrored row
+    constexpr uint64_t FlippedPixelBitMask = 0x8040201008040201;
+
+    constexpr uint64_t LowBitOfEachByte = 0x0101010101010101;
+
+    /// Spread the bits of a bit plane selected by `mask` to bit 0 of each byte
+    inline uint64_t SpreadBits(uint8_t bits, uint64_t mask)
+    {
+        uint64_t selected = (bits * LowBitOfEachByte) & mask;
+        // Every byte holds a single bit, which adding 0x7f carries to bit 7 without overflowing into the next byte
+        return ((selected + 0x7f7f7f7f7f7f7f7f) >> 7) & LowBitOfEachByte;
+    }
+
+    void DecodeTilePortable(const uint8_t *tile_data, uint8_t *pixels, uint8_t *flipped_pixels)
+    {
+        for (int y = 0; y < TileCache::TileHeight; y++)
+        {
+            uint8_t lobits = tile_data[y * 2];
+            uint8_t hibits = tile_data[y * 2 + 1];
+            uint64_t row = SpreadBits(lobits, PixelBitMask) | (SpreadBits(hibits, PixelBitMask) << 1);
+            uint64_t flipped_row = SpreadBits(lobits, FlippedPixelBitMask) | (SpreadBits(hibits, FlippedPixelBitMask) << 1);
+            memcpy(&pixels[y * TileCache::TileWidth], &row, sizeof(row));
+            memcpy(&flipped_pixels[y * TileCache::TileWidth], &flipped_row, sizeof(flipped_row));
+        }
+    }
+
+#ifdef MEGABOY_X86_SIMD
+    __attribute__((target("bmi2"))) void DecodeTileBMI2(const uint8_t *tile_data, uint8_t *pixels, uint8_t *flipped_pixels)
+    {
+        for (int y = 0; y < TileCache::TileHeight; y++)
+        {
+            // Bit i goes to byte i, which is the mirrored row. Reversing the bytes gives the row itself.
+            uint64_t flipped_row = _pdep_u64(tile_data[y * 2], LowBitOfEachByte) | _pdep_u64(tile_data[y * 2 + 1], LowBitOfEachByte << 1);
+            uint64_t row = __builtin_bswap64(flipped_row);
+            memcpy(&pixels[y * TileCache::TileWidth], &row, sizeof(row));
+            memcpy(&flipped_pixels[y * TileCache::TileWidth], &flipped_row, sizeof(flipped_row));
+        }
+    }
+
+    /// Color indices of the rows whose bit planes are broadcast to each 8 bytes of `lobits` and `hibits`
+    inline __m128i ExpandRowsSSE2(__m128i lobits, __m128i hibits, __m128i mask)
+    {
+        __m128i lo = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(lobits, mask), mask), _mm_set1_epi8(1));
+        __m128i hi = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(hibits, mask), mask), _mm_set1_epi8(2));
+        return _mm_or_si128(lo, hi);
+    }
+
+    void DecodeTileSSE2(const uint8_t *tile_data, uint8_t *pixels, uint8_t *flipped_pixels)
+    {
+        const __m128i mask = _mm_set1_epi64x(static_cast<int64_t>(PixelBitMask));
+        const __m128i flipped_mask = _mm_set1_epi64x(static_cast<int64_t>(FlippedPixelBitMask));
+
+        for (int y = 0; y < TileCache::TileHeight; y += 2)
+        {
+            __m128i lobits = _mm_set_epi64x(static_cast<int64_t>(tile_data[y * 2 + 2] * LowBitOfEachByte), static_cast<int64_t>(tile_data[y * 2] * LowBitOfEachByte));
+            __m128i hibits = _mm_set_epi64x(static_cast<int64_t>(tile_data[y * 2 + 3] * LowBitOfEachByte), static_cast<int64_t>(tile_data[y * 2 + 1] * LowBitOfEachByte));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&pixels[y * TileCache::TileWidth]), ExpandRowsSSE2(lobits, hibits, mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&flipped_pixels[y * TileCache::TileWidth]), ExpandRowsSSE2(lobits, hibits, flipped_mask));
+        }
+    }
+
+    __attribute__((target("avx2"))) inline __m256i ExpandRowsAVX2(__m256i lobits, __m256i hibits, __m256i mask)
+    {
+        __m256i lo = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(lobits, mask), mask), _mm256_set1_epi8(1));
+        __m256i hi = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(hibits, mask), mask), _mm256_set1_epi8(2));
+        return _mm256_or_si256(lo, hi);
+    }
+
+    __attribute__((target("avx2"))) void DecodeTileAVX2(const uint8_t *tile_data, uint8_t *pixels, uint8_t *flipped_pixels)
+    {
+        const __m256i mask = _mm256_set1_epi64x(static_cast<int64_t>(PixelBitMask));
+        const __m256i flipped_mask = _mm256_set1_epi64x(static_cast<int64_t>(FlippedPixelBitMask));
+        // Broadcast byte 2 * i of the 8 bytes loaded to the 8 bytes of row i, and byte 2 * i + 1 for the high bit plane
+        const __m256i lo_shuffle = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 6, 6, 6, 6, 6, 6, 6, 6);
+        const __m256i hi_shuffle = _mm256_setr_epi8(1, 1, 1, 1, 1, 1, 1, 1, 3, 3, 3, 3, 3, 3, 3, 3, 5, 5, 5, 5, 5, 5, 5, 5, 7, 7, 7, 7, 7, 7, 7, 7);
+
+        for (int y = 0; y < TileCache::TileHeight; y += 4)
+        {
+            int64_t rows;
+            memcpy(&rows, &tile_data[y * 2], sizeof(rows));
+            // The shuffle works within each 128 bit lane, so both lanes get all 8 bytes
+            __m256i data = _mm256_set1_epi64x(rows);
+            __m256i lobits = _mm256_shuffle_epi8(data, lo_shuffle);
+            __m256i hibits = _mm256_shuffle_epi8(data, hi_shuffle);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(&pixels[y * TileCache::TileWidth]), ExpandRowsAVX2(lobits, hibits, mask));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(&flipped_pixels[y * TileCache::TileWidth]), ExpandRowsAVX2(lobits, hibits, flipped_mask));
+        }
+    }
+#endif
+}
+
+bool TileCache::IsSupported(Decoder decoder)
+{
+    switch (decoder)
+    {
+    case Decoder::Portable:
+        return true;
+#ifdef MEGABOY_X86_SIMD
+    case Decoder::BMI2:
+        return __builtin_cpu_supports("bmi2");
+    case Decoder::SSE2:
+        return true;
+    case Decoder::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+TileCache::Decoder TileCache::FastestDecoder()
+{
+    // PDEP is microcoded and slow on AMD CPUs before Zen 3, so BMI2 is never picked over SSE2
+    for (Decoder decoder : {Decoder::AVX2, Decoder::SSE2})
+    {
+        if (IsSupported(decoder))
+        {
+            return decoder;
+        }
+    }
+    return Decoder::Portable;
+}
+
+void TileCache::DecodeTile(Decoder decoder, const uint8_t *tile_data, uint8_t *pixels, uint8_t *flipped_pixels)
+{
+    switch (decoder)
+    {
+#ifdef MEGABOY_X86_SIMD
+    case Decoder::BMI2:
+        DecodeTileBMI2(tile_data, pixels, flipped_pixels);
+        break;
+    case Decoder::SSE2:
+        DecodeTileSSE2(tile_data, pixels, flipped_pixels);
+        break;
+    case Decoder::AVX2:
+        DecodeTileAVX2(tile_data, pixels, flipped_pixels);
+        break;
+#endif
+    default:
+        DecodeTilePortable(tile_data, pixels, flipped_pixels);
+        break;
+    }
+}
+
+void TileCache::Decode(uint16_t tile)
+{
+    DecodedTile &decoded = decoded_tiles[tile];
+    DecodeTile(decoder, &mem.memory[HostMemory::TileDataStart + tile * 16], decoded.pixels, decoded.flipped_pixels);
+    mem.modified_tiles[tile] = false;
+    versions[tile]++;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "../HostMemory.h"
+
+/// The tiles of VRAM (0x8000 - 0x97ff) decoded from 2 bits per pixel in two bit planes to one color index (0-3) per byte.
+///
+/// Every scanline draws up to 32 background tiles, 21 window tiles and 10 sprite rows, while tile data rarely changes between frames.
+/// A tile is only decoded again when it is drawn after a write to it, which HostMemory records in `modified_tiles`.
+class TileCache
+{
+public:
+    static constexpr uint8_t TileWidth = 8;
+    static constexpr uint8_t TileHeight = 8;
+
+    /// Implementations of decoding a tile, which all give the same result
+    enum class Decoder : uint8_t
+    {
+        /// Spreads the bits of a bit plane to bytes with a multiplication
+        Portable,
+        /// Deposits the bits of a bit plane to bytes with PDEP
+        BMI2,
+        /// Tests the bits of two rows at once against a mask per byte
+        SSE2,
+        /// Tests the bits of four rows at once against a mask per byte
+        AVX2
+    };
+
+    /// Whether the CPU running the emulator supports `decoder`
+    static bool IsSupported(Decoder decoder);
+
+    /// The fastest decoder the CPU supports
+    static Decoder FastestDecoder();
+
+    explicit TileCache(HostMemory &mem) : mem(mem)
+    {
+    }
+
+    /// Decoder used for tiles decoded from now on
+    Decoder decoder = FastestDecoder();
+
+    /// The color indices of a row of a tile, left to right, or right to left if `x_flip` is set.
+    /// \param row_address address of the two bytes of the row in VRAM, as in the 2bpp tile data
+    const uint8_t *GetRow(uint16_t row_address, bool x_flip = false)
+    {
+        uint16_t tile = (row_address - HostMemory::TileDataStart) >> 4;
+        if (mem.modified_tiles[tile])
+        {
+            Decode(tile);
+        }
+        const DecodedTile &decoded = decoded_tiles[tile];
+        uint8_t row_offset = ((row_address >> 1) & 0b111) * TileWidth;
+        return x_flip ? &decoded.flipped_pixels[row_offset] : &decoded.pixels[row_offset];
+    }
+
+    /// The color indices of a whole tile, row by row
+    /// \param tile index of the tile in VRAM (0-383)
+    const uint8_t *GetTile(uint16_t tile)
+    {
+        if (mem.modified_tiles[tile])
+        {
+            Decode(tile);
+        }
+        return decoded_tiles[tile].pixels;
+    }
+
+    /// Changes every time a tile is decoded again after a write to it, so what was drawn from it can be checked to still be current
+    uint32_t Version(uint16_t tile)
+    {
+        if (mem.modified_tiles[tile])
+        {
+            Decode(tile);
+        }
+        return versions[tile];
+    }
+
+    /// Decode a whole tile with `decoder`
+    /// \param tile_data the 16 bytes of a tile in VRAM
+    /// \param pixels 64 color indices, row by row
+    /// \param flipped_pixels the same color indices with every row mirrored
+    static void DecodeTile(Decoder decoder, const uint8_t *tile_data, uint8_t *pixels, uint8_t *flipped_pixels);
+
+private:
+    HostMemory &mem;
+
+    struct DecodedTile
+    {
+        uint8_t pixels[TileWidth * TileHeight];
+        /// Mirrored rows for sprites with X flip
+        uint8_t flipped_pixels[TileWidth * TileHeight];
+    };
+
+    std::array<DecodedTile, HostMemory::TileCount> decoded_tiles{};
+    std::array<uint32_t, HostMemory::TileCount> versions{};
+
+    void Decode(uint16_t tile);
+};
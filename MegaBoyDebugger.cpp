@@ -15,7 +15,6 @@ MegaBoyDebugger::MegaBoyDebugger()
 {
 
     gb = std::make_unique<Gameboy>();
-    screenData = reinterpret_cast<uint8_t *>(&gb->lcd.rgbBuffer);
     gb->cpu.reset();
 }
 
@@ -164,6 +163,16 @@ void MegaBoyDebugger::LoadRom(std::filesystem::path filename)
         // memcpy(&gb->mem[0],buffer, size);
         delete[] buffer;
         z80file.close();
+
+#ifdef MEGABOY_AOT
+        // Use the code recompiled by megaboy-aot if it has been built for this ROM
+        auto library_path = std::filesystem::path(path).replace_extension(".aot.so");
+        if (exists(library_path) && gb->cpu.aot.Load(library_path.string(), gb->cartridge.GetHeader()))
+        {
+            std::cout << "Loaded " << gb->cpu.aot.BlockCount() << " recompiled blocks from " << library_path << std::endl;
+            gb->cpu.reset();
+        }
+#endif
     }
 }
 
@@ -202,6 +211,11 @@ void MegaBoyDebugger::UpdateUI()
             {
                 DrawCartridgeHeader();
             }
+
+            if (ImGui::CollapsingHeader("Idle loops"))
+            {
+                DrawIdleLoopStatistics();
+            }
         }
         ImGui::End();
     }
@@ -254,58 +268,82 @@ void MegaBoyDebugger::DrawCartridgeHeader()
     }
 }
 
+void MegaBoyDebugger::DrawIdleLoopStatistics()
+{
+    ImGui::Checkbox("Skip idle loops", &gb->cpu.use_idle_loop_skipping);
+
+    ImGui::Text("Loops found:");
+    ImGui::SameLine();
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "%llu", static_cast<unsigned long long>(gb->cpu.idle_loop.detected_loops));
+
+    ImGui::Text("Iterations skipped:");
+    ImGui::SameLine();
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "%llu", static_cast<unsigned long long>(gb->cpu.idle_loop.skipped_iterations));
+
+    ImGui::Text("Cycles skipped:");
+    ImGui::SameLine();
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "%llu", static_cast<unsigned long long>(gb->cpu.idle_loop.skipped_cycles));
+
+    if (gb->cpu.idle_loop.active)
+    {
+        ImGui::Text("In idle loop at");
+        ImGui::SameLine();
+        ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->cpu.idle_loop.loop_pc);
+    }
+}
+
 void MegaBoyDebugger::DrawTimerRegisters()
 {
     ImGui::Text("FF04 - DIV (Divider)");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xFF04]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xFF04));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xFF04]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xFF04));
 
     ImGui::Text("FF05 - TIMA (Counter)");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xFF05]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xFF05));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xFF05]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xFF05));
 
     ImGui::Text("FF06 - TMA (Modulo)");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xFF06]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xFF06));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xFF06]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xFF06));
 
     ImGui::Text("FF07 - TAC (Timer Control)");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xFF07]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xFF07));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xFF07]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xFF07));
 }
 
 void MegaBoyDebugger::DrawPPURegisters()
 {
     ImGui::Text("FF42 - SCY:");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xFF42]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xFF42));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xFF42]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xFF42));
 
     ImGui::Text("FF43 - SCX:");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xFF43]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xFF43));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xFF43]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xFF43));
 
     ImGui::Text("FF44 - LY :");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xff44]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xff44));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xff44]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xff44));
 
     ImGui::Text("FF45 - LYC:");
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem[0xff45]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_HEX, "0x%04x", gb->mem.Read(0xff45));
     ImGui::SameLine();
-    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem[0xff45]);
+    ImGui::TextColored(UIConfig::COLOR_VALUE_DECIMAL, "(%d)", gb->mem.Read(0xff45));
 }
 
 void MegaBoyDebugger::DrawDebuggingControls()
@@ -349,7 +387,7 @@ void MegaBoyDebugger::DrawDebuggingControls()
     {
         std::string addr_string = addr_input;
         unsigned int addr_int = std::stoul(addr_string, nullptr, 16);
-        run_to = addr_int;
+        run_to = static_cast<uint16_t>(addr_int);
         is_running = true;
     };
 }
@@ -361,21 +399,13 @@ void MegaBoyDebugger::SetKeyState(Joypad::Button button, bool pressed)
 
 void MegaBoyDebugger::Run()
 {
-    int cycles = 0;
+    // One frame per UI update, ending at VBlank with the frame drawn
+    gb->breakpoint = run_to;
+    gb->RunFrame();
 
-    // std::this_thread::sleep_for(std::chrono::nanoseconds (1/4194304));
-    //  The CPU clock rate is fixed at 2MHz, so a single clock cycle is 1/2000000s = 0.5µs. The frametime is the inverse of the refresh rate; so if the refresh rate is 60Hz, the frame time is 1/60s or ~16ms. The ratio is 16ms/0.5µs ~~ 33000.
-    //  67108 cycles pr frame
-    constexpr int CYCLES_PR_FRAME = 67108;
-    while (cycles < CYCLES_PR_FRAME)
+    if (run_to && gb->cpu.regs.PC == *run_to)
     {
-        cycles += gb->Step();
-
-        if (gb->cpu.regs.PC == run_to)
-        {
-            is_running = false;
-            break;
-        }
+        is_running = false;
     }
 }
 
@@ -21,7 +21,7 @@ private:
     bool scroll_to_bottom = false;
 
     bool is_running = false;
-    uint16_t run_to = 0xffff;
+    std::optional<uint16_t> run_to;
 
     std::unique_ptr<Gameboy> gb;
 
@@ -40,6 +40,7 @@ public:
     void DrawCartridgeHeader();
     void DrawTimerRegisters();
     void DrawPPURegisters();
+    void DrawIdleLoopStatistics();
 
     void LoadRom(std::filesystem::path filename);
 
@@ -55,8 +56,11 @@ public:
     // The native code should set a callback on this property and spawn a native file picker UI when called.
     std::function<void()> onOpenFile = nullptr;
 
-    static constexpr uint16_t GB_SCREEN_WIDTH = 256;
-    static constexpr uint16_t GB_SCREEN_HEIGHT = 256;
-    /// RGB screen data
-    uint8_t *screenData;
+    static constexpr uint16_t GB_SCREEN_WIDTH = Framebuffer::Width;
+    static constexpr uint16_t GB_SCREEN_HEIGHT = Framebuffer::Height;
+    /// RGBA screen data. Read it every time it is uploaded, as it moves when the framebuffer format is set.
+    [[nodiscard]] const uint8_t *ScreenData() const
+    {
+        return gb->lcd.framebuffer.Data();
+    }
 };
@@ -0,0 +1,14 @@
+#include <algorithm>
+#include "Scheduler.h"
+
+void Scheduler::Reset()
+{
+    now = 0;
+    deadlines.fill(Never);
+    next_deadline = Never;
+}
+
+void Scheduler::UpdateNextDeadline()
+{
+    next_deadline = *std::min_element(deadlines.begin(), deadlines.end());
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/// Master clock of a Gameboy, and the cycle each component next has something to do at.
+///
+/// Components are only stepped when their deadline is reached, or when the CPU writes to their registers (see Gameboy::Step).
+/// There are only a few components, so deadlines are kept in a fixed array with the earliest one cached,
+/// which is cheaper to check after every instruction than a heap.
+class Scheduler
+{
+public:
+    enum class Event : uint8_t
+    {
+        /// DIV or TIMA changes (see Timer::CyclesUntilNextEvent)
+        Timer,
+        /// Scanline or LCD mode change (see LCD::CyclesUntilNextEvent)
+        LCD,
+        /// Bytes of an OAM DMA transfer in progress
+        DMA
+    };
+
+    static constexpr uint8_t EventCount = 3;
+    static constexpr uint64_t Never = UINT64_MAX;
+
+    /// Cycles since reset
+    uint64_t now = 0;
+
+    void Reset();
+
+    void Schedule(Event event, uint64_t deadline)
+    {
+        deadlines[static_cast<uint8_t>(event)] = deadline;
+        UpdateNextDeadline();
+    }
+
+    void Cancel(Event event)
+    {
+        Schedule(event, Never);
+    }
+
+    [[nodiscard]] uint64_t Deadline(Event event) const
+    {
+        return deadlines[static_cast<uint8_t>(event)];
+    }
+
+    /// The earliest deadline of all events
+    [[nodiscard]] uint64_t NextDeadline() const
+    {
+        return next_deadline;
+    }
+
+private:
+    std::array<uint64_t, EventCount> deadlines{Never, Never, Never};
+    uint64_t next_deadline = Never;
+
+    void UpdateNextDeadline();
+};
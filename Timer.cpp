@@ -13,6 +13,7 @@
 #include <chrono>
 #include <mutex>
 #include <functional>
+#include <algorithm>
 #include "HostMemory.h"
 
 void Timer::Reset()
@@ -25,29 +26,46 @@ void Timer::Reset()
 
 void Timer::Step(uint16_t ticks)
 {
-    for (int i = 0; i < ticks; i++)
+    // divider is ALWAYS increasing, regardless of TimerEnabled state in control register
+    uint32_t previous_divider_value = divider_register;
+    uint32_t new_divider_value = previous_divider_value + ticks;
+    divider_register = static_cast<uint16_t>(new_divider_value);
+
+    if (timer_control_register & TimerEnabledBitmask)
     {
-        Step();
+        // TIMA is increased on every falling edge of the selected divider bit (see DividerWasUpdated),
+        // which is every time the divider passes a multiple of twice that bit. The divider is not wrapped here,
+        // so an edge at the 16 bit wraparound is counted too.
+        uint32_t period = Period();
+        uint32_t increments = new_divider_value / period - previous_divider_value / period;
+        Increase(increments);
     }
 }
 
 void Timer::Step()
 {
-    // divider is ALWAYS increasing, regardless of TimerEnabled state in control register
-    uint16_t previous_divider_value = divider_register;
-    divider_register += 1;
-
-    mem[static_cast<uint16_t>(IOAddress::TimerModule)] = GetModulo();
-    mem[static_cast<uint16_t>(IOAddress::TimerDivider)] = GetDividerRegister();
-    mem[static_cast<uint16_t>(IOAddress::TimerControl)] = GetTimerControl();
-    mem[static_cast<uint16_t>(IOAddress::TimerCounter)] = GetCounter();
+    Step(1);
+}
 
-    DividerWasUpdated(previous_divider_value, divider_register);
+void Timer::Increase(uint32_t increments)
+{
+    while (increments > 0)
+    {
+        uint32_t until_overflow = 0x100 - timer_counter;
+        if (increments < until_overflow)
+        {
+            timer_counter += increments;
+            return;
+        }
 
-    mem[static_cast<uint16_t>(IOAddress::TimerModule)] = GetModulo();
-    mem[static_cast<uint16_t>(IOAddress::TimerDivider)] = GetDividerRegister();
-    mem[static_cast<uint16_t>(IOAddress::TimerControl)] = GetTimerControl();
-    mem[static_cast<uint16_t>(IOAddress::TimerCounter)] = GetCounter();
+        increments -= until_overflow;
+        timer_counter = timer_modulo;
+        // Set timer interrupt flag (Request timer interrupt)
+        if (didOverflow != nullptr)
+        {
+            didOverflow();
+        }
+    }
 }
 
 void Timer::DividerWasUpdated(uint16_t previous_divider_value, uint16_t new_divider_value)
@@ -80,19 +98,7 @@ void Timer::DividerWasUpdated(uint16_t previous_divider_value, uint16_t new_divi
 
     if (increase_timer)
     {
-        uint8_t last_timer_counter = timer_counter;
-        timer_counter++;
-
-        // Did timer overflow?
-        if (timer_counter < last_timer_counter)
-        {
-            timer_counter = timer_modulo;
-            // Set timer interrupt flag (Request timer interrupt)
-            if (didOverflow != nullptr)
-            {
-                didOverflow();
-            }
-        }
+        Increase(1);
     }
 }
 
@@ -151,3 +157,46 @@ void Timer::SetTimerControl(uint8_t value)
 {
     return timer_control_register;
 }
+
+uint16_t Timer::CyclesUntilNextEvent() const
+{
+    // DIV is the upper 8 bits of the divider
+    uint16_t cycles = 256 - (divider_register & 0xff);
+
+    if (timer_control_register & TimerEnabledBitmask)
+    {
+        // TIMA is increased on the falling edge of the divider bit selected in DividerWasUpdated,
+        // which happens every time the divider passes a multiple of twice that bit.
+        uint16_t period = Period();
+        cycles = std::min<uint16_t>(cycles, period - (divider_register & (period - 1)));
+    }
+
+    return cycles;
+}
+
+uint16_t Timer::CyclesUntilOverflow() const
+{
+    if (!(timer_control_register & TimerEnabledBitmask))
+    {
+        return 0xffff;
+    }
+
+    uint32_t period = Period();
+    // The next increment, then one more period for each increment left until TIMA passes 0xff
+    uint32_t cycles = period - (divider_register & (period - 1)) + (0xff - timer_counter) * period;
+
+    return std::min<uint32_t>(cycles, 0xffff);
+}
+
+uint16_t Timer::CyclesSinceLastEvent() const
+{
+    uint16_t cycles = divider_register & 0xff;
+
+    if (timer_control_register & TimerEnabledBitmask)
+    {
+        uint16_t period = Period();
+        cycles = std::min<uint16_t>(cycles, divider_register & (period - 1));
+    }
+
+    return cycles;
+}
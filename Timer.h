@@ -40,19 +40,15 @@ private:
     constexpr static uint8_t TimerEnabledBitmask = 0b100;
     constexpr static uint8_t TimerMultiplierBitmask = 0b011;
 
-    HostMemory &mem;
-
 public:
     std::function<void()> didOverflow = nullptr;
 
-    Timer() = delete;
-
-    explicit Timer(HostMemory &mem) : mem(mem)
-    {
-    }
+    Timer() = default;
 
     void Reset();
 
+    /// Advance the timer by a number of cycles at once. DIV and the increments of TIMA are computed from how far the divider moves,
+    /// so this costs the same for any number of cycles, plus one call of `didOverflow` per overflow.
     void Step(uint16_t ticks);
     void Step();
 
@@ -84,6 +80,27 @@ public:
 
     [[nodiscard]] uint8_t GetTimerControl() const;
 
+    /// Number of cycles until the timer next changes a value the CPU can observe:
+    /// the upper 8 bits of the divider (DIV) or an increment of TIMA.
+    [[nodiscard]] uint16_t CyclesUntilNextEvent() const;
+
+    /// Number of cycles until TIMA overflows and requests the timer interrupt, if nothing writes to the timer registers before that.
+    /// 0xffff if the timer is disabled or the overflow is further away than that.
+    [[nodiscard]] uint16_t CyclesUntilOverflow() const;
+
+    /// Number of cycles since DIV or TIMA last changed by counting
+    [[nodiscard]] uint16_t CyclesSinceLastEvent() const;
+
 private:
+    /// Cycles between increments of TIMA selected in TAC
+    [[nodiscard]] uint16_t Period() const
+    {
+        static constexpr uint16_t periods[] = {1024, 16, 64, 256};
+        return periods[timer_control_register & TimerMultiplierBitmask];
+    }
+
+    /// Increase TIMA, reloading it from TMA and requesting the interrupt on every overflow
+    void Increase(uint32_t increments);
+
     void DividerWasUpdated(uint16_t previous_divider_value, uint16_t new_divider_value);
 };
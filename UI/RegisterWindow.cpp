@@ -8,6 +8,8 @@
 
 void RegisterWindow::UpdateUI(CPU &cpu) {
 
+    cpu.materialize_flags();
+
     // Create window
     //ImGui::Begin("Registers");
 
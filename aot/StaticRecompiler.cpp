@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <set>
+#include "StaticRecompiler.h"
+#include "../CPU/cpu.h"
+#include "../CPU/native_block.h"
+#include "../CPU/aot_abi.h"
+#include "../cartridge/CartridgeHeader.h"
+
+static constexpr uint16_t BankSize = 0x4000;
+
+/// JR, JR cc, JP nn and JP cc,nn
+static bool IsDirectJump(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+    case 0xc3: case 0xc2: case 0xca: case 0xd2: case 0xda:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool IsConditionalJump(uint8_t opcode)
+{
+    return IsDirectJump(opcode) && opcode != 0x18 && opcode != 0xc3;
+}
+
+/// Target address of a direct jump or a call
+static uint16_t JumpTarget(const DisassemblyLine &line)
+{
+    const uint8_t *bytes = line.instructionBytes.data;
+    if (bytes[0] < 0x40)
+    {
+        // JR: relative to the next instruction
+        return line.PC + line.numberOfBytes + static_cast<int8_t>(bytes[1]);
+    }
+    return bytes[1] | (bytes[2] << 8);
+}
+
+static const char *RegisterName(uint8_t register_code)
+{
+    static constexpr const char *names[] = {"B", "C", "D", "E", "H", "L", "(HL)", "A"};
+    return names[register_code];
+}
+
+static const char *RegisterPairName(uint8_t opcode)
+{
+    static constexpr const char *names[] = {"BC", "DE", "HL", "SP"};
+    return names[(opcode >> 4) & 0b11];
+}
+
+StaticRecompiler::StaticRecompiler(std::vector<uint8_t> rom) : rom(std::move(rom))
+{
+    bank_count = static_cast<uint16_t>(std::max<size_t>(2, (this->rom.size() + BankSize - 1) / BankSize));
+}
+
+uint8_t StaticRecompiler::Read(uint16_t bank, uint16_t address) const
+{
+    size_t offset = address < BankSize ? address : bank * BankSize + (address - BankSize);
+    return offset < rom.size() ? rom[offset] : 0xff;
+}
+
+void StaticRecompiler::FindBlocks()
+{
+    std::vector<std::pair<uint16_t, uint16_t>> queue;
+
+    // Cartridge entry point, RST vectors and interrupt vectors
+    queue.emplace_back(0, 0x100);
+    for (uint16_t vector = 0x00; vector <= 0x60; vector += 8)
+    {
+        queue.emplace_back(0, vector);
+    }
+
+    std::set<uint32_t> visited;
+    while (!queue.empty())
+    {
+        auto [bank, pc] = queue.back();
+        queue.pop_back();
+
+        uint32_t key = (static_cast<uint32_t>(bank) << 16) | pc;
+        if (!visited.insert(key).second)
+        {
+            continue;
+        }
+
+        Block block = DecodeBlock(bank, pc);
+        AddSuccessors(block, queue);
+        if (!block.instructions.empty())
+        {
+            blocks.emplace(key, std::move(block));
+        }
+    }
+}
+
+StaticRecompiler::Block StaticRecompiler::DecodeBlock(uint16_t bank, uint16_t pc)
+{
+    Block block;
+    block.bank = bank;
+    block.pc = pc;
+
+    // Bank 0 and the switchable bank are not contiguous in the ROM
+    uint32_t region_end = pc < BankSize ? BankSize : 2 * BankSize;
+    uint32_t address = pc;
+
+    while (block.instructions.size() < BlockCache::MaxBlockLength)
+    {
+        uint8_t opcode = Read(bank, address);
+        if (TranslationOf(opcode) == Translation::Unsupported)
+        {
+            break;
+        }
+
+        InstructionBytes bytes = {opcode, Read(bank, address + 1), Read(bank, address + 2)};
+        DisassemblyLine line = disassembler.Disassemble(bytes, address);
+        if (address + line.numberOfBytes > region_end)
+        {
+            break;
+        }
+
+        uint8_t cycles = opcode == 0xcb ? CPU::bit_opcode_table[bytes.data[1]].cycles : CPU::opcode_table[opcode].cycles;
+        block.cycles += cycles;
+        block.instructions.push_back({line, cycles});
+
+        address += line.numberOfBytes;
+        if (IsDirectJump(opcode) || IsIndirectControlFlow(opcode))
+        {
+            break;
+        }
+    }
+
+    return block;
+}
+
+void StaticRecompiler::AddSuccessors(const Block &block, std::vector<std::pair<uint16_t, uint16_t>> &queue) const
+{
+    auto add = [&](uint32_t address)
+    {
+        if (address < BankSize)
+        {
+            queue.emplace_back(0, address);
+        }
+        else if (address < 2 * BankSize && block.bank != 0)
+        {
+            queue.emplace_back(block.bank, address);
+        }
+        else if (address < 2 * BankSize)
+        {
+            // Any bank could be mapped in when bank 0 jumps to the switchable bank
+            for (uint16_t bank = 1; bank < bank_count; bank++)
+            {
+                queue.emplace_back(bank, address);
+            }
+        }
+    };
+
+    uint32_t next = block.pc;
+    if (!block.instructions.empty())
+    {
+        const DisassemblyLine &last = block.instructions.back().line;
+        uint8_t opcode = last.instructionBytes.data[0];
+        next = last.PC + last.numberOfBytes;
+
+        if (IsDirectJump(opcode) || (opcode >= 0xc4 && opcode <= 0xdc && (opcode & 0b111) == 0b100) || opcode == 0xcd)
+        {
+            // Jumps and calls
+            add(JumpTarget(last));
+            if (IsConditionalJump(opcode) || opcode == 0xcd || (opcode & 0b111) == 0b100)
+            {
+                add(next);
+            }
+            return;
+        }
+
+        if ((opcode & 0b11000111) == 0b11000111)
+        {
+            // RST, continuing after the routine returns
+            add(opcode & 0b00111000);
+            add(next);
+            return;
+        }
+
+        if (opcode == 0xc0 || opcode == 0xc8 || opcode == 0xd0 || opcode == 0xd8)
+        {
+            // RET cc
+            add(next);
+            return;
+        }
+
+        if (IsIndirectControlFlow(opcode))
+        {
+            // RET, JP (HL)
+            return;
+        }
+    }
+
+    // The block ended before an instruction that is never recompiled, or at its maximum length
+    uint8_t opcode = Read(block.bank, next);
+    switch (opcode)
+    {
+    case 0x10: // STOP
+        add(next + 2);
+        break;
+    case 0x76: // HALT
+    case 0xf3: // DI
+    case 0xfb: // EI
+        add(next + 1);
+        break;
+    default:
+        if (TranslationOf(opcode) != Translation::Unsupported)
+        {
+            add(next);
+        }
+        break;
+    }
+}
+
+std::string StaticRecompiler::BlockName(const Block &block)
+{
+    return std::format("block_{:04x}_{:04x}", block.bank, block.pc);
+}
+
+/// C++ for a native instruction, see `TranslationOf`. Control flow is generated by `GenerateBlock`.
+static std::string NativeInstruction(const DisassemblyLine &line)
+{
+    uint8_t opcode = line.instructionBytes.data[0];
+    uint8_t n = line.instructionBytes.data[1];
+    uint16_t nn = line.instructionBytes.data[1] | (line.instructionBytes.data[2] << 8);
+    uint8_t dst = (opcode >> 3) & 0b111;
+    uint8_t src = opcode & 0b111;
+
+    switch (opcode)
+    {
+    case 0x00:
+        return "";
+    case 0x01: case 0x11: case 0x21: case 0x31:
+        return std::format("regs.{} = 0x{:04x};", RegisterPairName(opcode), nn);
+    case 0x03: case 0x13: case 0x23: case 0x33:
+        return std::format("regs.{}++;", RegisterPairName(opcode));
+    case 0x0b: case 0x1b: case 0x2b: case 0x3b:
+        return std::format("regs.{}--;", RegisterPairName(opcode));
+    case 0x2f:
+        return "AOTRuntime::Cpl(regs);";
+    case 0x37:
+        return "AOTRuntime::Scf(regs);";
+    case 0x3f:
+        return "AOTRuntime::Ccf(regs);";
+    default:
+        break;
+    }
+
+    if (opcode >= 0x80)
+    {
+        // ALU A,r and ALU A,n
+        std::string value = opcode >= 0xc0 ? std::format("0x{:02x}", n) : std::format("regs.{}", RegisterName(src));
+        static constexpr const char *operations[] = {"Add", "Add", "Sub", "Sub", "And", "Xor", "Or", "Sub"};
+        static constexpr const char *carry_and_compare[] = {", false", ", true", ", false, false", ", true, false", "", "", "", ", false, true"};
+        return std::format("AOTRuntime::{}(regs, {}{});", operations[dst], value, carry_and_compare[dst]);
+    }
+
+    if (opcode >= 0x40)
+    {
+        return std::format("regs.{} = regs.{};", RegisterName(dst), RegisterName(src));
+    }
+
+    if (src == 0b110)
+    {
+        return std::format("regs.{} = 0x{:02x};", RegisterName(dst), n);
+    }
+
+    return std::format("AOTRuntime::{}(regs, regs.{});", src == 0b100 ? "Inc" : "Dec", RegisterName(dst));
+}
+
+std::string StaticRecompiler::GenerateBlock(const Block &block)
+{
+    std::string code = std::format("static uint32_t {}(CPU *cpu, void *r, [[maybe_unused]] uint32_t budget)\n{{\n", BlockName(block));
+    code += "    auto &regs = *static_cast<AOTRegisters *>(r);\n";
+    code += "    uint32_t cycles = 0;\n";
+    code += "    [[maybe_unused]] uint32_t spent;\n";
+    code += "    for (;;)\n    {\n";
+
+    // Exit at the end of the block, jumping back to the start while the next pass fits in the budget
+    auto exit_to = [&](uint16_t target, const char *indent)
+    {
+        std::string exit;
+        if (target == block.pc)
+        {
+            exit += std::format("{}if (cycles + {} <= budget)\n{}{{\n{}    continue;\n{}}}\n", indent, block.cycles, indent, indent, indent);
+        }
+        exit += std::format("{}regs.PC = 0x{:04x};\n{}return cycles;\n", indent, target, indent);
+        return exit;
+    };
+
+    bool exited = false;
+    for (const auto &[line, cycles] : block.instructions)
+    {
+        uint8_t opcode = line.instructionBytes.data[0];
+        uint16_t next = line.PC + line.numberOfBytes;
+        code += std::format("        // {:04x}: {}\n", line.PC, line.text);
+
+        if (TranslationOf(opcode) == Translation::Interpreted)
+        {
+            uint32_t encoded = EncodeInstruction(opcode, &line.instructionBytes.data[1]);
+            code += std::format("        if ((spent = interpret(cpu, 0x{:06x}, 0x{:04x})) == 0)\n", encoded, line.PC);
+            code += "        {\n            return cycles;\n        }\n";
+            code += "        cycles += spent;\n";
+            if (IsIndirectControlFlow(opcode))
+            {
+                code += "        return cycles;\n";
+                exited = true;
+                break;
+            }
+            continue;
+        }
+
+        code += std::format("        cycles += {};\n", cycles);
+
+        if (IsConditionalJump(opcode))
+        {
+            // Condition in bits 3-4: NZ, Z, NC, C
+            static constexpr const char *conditions[] = {"!(regs.F & 0x80)", "regs.F & 0x80", "!(regs.F & 0x10)", "regs.F & 0x10"};
+            code += std::format("        if ({})\n        {{\n", conditions[(opcode >> 3) & 0b11]);
+            code += exit_to(JumpTarget(line), "            ");
+            code += "        }\n";
+            code += exit_to(next, "        ");
+            exited = true;
+            break;
+        }
+
+        if (IsDirectJump(opcode))
+        {
+            code += exit_to(JumpTarget(line), "        ");
+            exited = true;
+            break;
+        }
+
+        std::string native = NativeInstruction(line);
+        if (!native.empty())
+        {
+            code += "        " + native + "\n";
+        }
+    }
+
+    if (!exited)
+    {
+        const DisassemblyLine &last = block.instructions.back().line;
+        code += exit_to(last.PC + last.numberOfBytes, "        ");
+    }
+
+    code += "    }\n}\n\n";
+    return code;
+}
+
+std::string StaticRecompiler::GenerateSource()
+{
+    CartridgeHeader header{};
+    if (rom.size() >= 0x100 + sizeof(CartridgeHeader))
+    {
+        std::memcpy(&header, &rom[0x100], sizeof(CartridgeHeader));
+    }
+
+    std::string source = "// Generated by megaboy-aot, do not edit.\n\n";
+    source += "#include \"aot_abi.h\"\n\n";
+    source += "static AOTInterpretFunction interpret = nullptr;\n\n";
+
+    for (const auto &[key, block] : blocks)
+    {
+        source += GenerateBlock(block);
+    }
+
+    source += "static const AOTBlock blocks[] = {\n";
+    for (const auto &[key, block] : blocks)
+    {
+        source += std::format("    {{0x{:04x}, 0x{:04x}, {}, &{}}},\n", block.bank, block.pc, block.cycles, BlockName(block));
+    }
+    source += "};\n\n";
+
+    source += std::format("extern \"C\" const AOTModule {} = {{{}, 0x{:06x}, {}, blocks, &interpret}};\n", AOTModuleSymbol,
+                          AOTAbiVersion, AOTROMId(header.header_checksum, header.global_checksum), blocks.size());
+    return source;
+}
+
+bool StaticRecompiler::CompileLibrary(const std::string &compiler, const std::filesystem::path &include_dir,
+                                      const std::filesystem::path &source, const std::filesystem::path &library)
+{
+    std::string command = std::format("{} -std=c++17 -O2 -shared -fPIC -I\"{}\" -o \"{}\" \"{}\"", compiler, include_dir.string(),
+                                      library.string(), source.string());
+    return std::system(command.c_str()) == 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../disassembler/disassembler.h"
+
+/// Ahead-of-time recompiler turning the code of a cartridge into C++, to be compiled into a shared object
+/// that the emulator loads with `AOTLibrary` (see CPU/aot.h).
+///
+/// Code is found by walking the ROM from the entry points (0x100, the RST and the interrupt vectors), following jumps, calls and
+/// fall-throughs within each bank. Jumps from bank 0 into 0x4000 - 0x7fff could go to any bank, so they are followed in all of them.
+/// Code that isn't reached this way (jumps through HL or tables) and code in RAM is left to the JIT and the interpreter.
+///
+/// Blocks are split by the same rules as the BlockCache, and translate the same instructions to native code as the JIT,
+/// calling back into the interpreter for the rest (see native_block.h).
+class StaticRecompiler
+{
+public:
+    /// \param rom contents of the cartridge ROM
+    explicit StaticRecompiler(std::vector<uint8_t> rom);
+
+    /// Find and decode all reachable blocks
+    void FindBlocks();
+
+    /// C++ source of a library holding all blocks found, see CPU/aot_abi.h
+    [[nodiscard]] std::string GenerateSource();
+
+    /// Compile a generated source file into a shared object.
+    /// \param compiler C++ compiler command
+    /// \param include_dir directory of aot_abi.h
+    /// \returns whether the compiler succeeded
+    static bool CompileLibrary(const std::string &compiler, const std::filesystem::path &include_dir,
+                               const std::filesystem::path &source, const std::filesystem::path &library);
+
+    [[nodiscard]] size_t BlockCount() const
+    {
+        return blocks.size();
+    }
+
+private:
+    struct BlockInstruction
+    {
+        DisassemblyLine line;
+        /// Cycles from the interpreter's opcode tables, which the disassembler doesn't always agree with
+        uint8_t cycles = 0;
+    };
+
+    struct Block
+    {
+        uint16_t bank = 0;
+        uint16_t pc = 0;
+        /// Cycles of one pass through the block
+        uint16_t cycles = 0;
+        std::vector<BlockInstruction> instructions;
+    };
+
+    std::vector<uint8_t> rom;
+    uint16_t bank_count;
+    Disassembler disassembler;
+    /// Blocks keyed by (bank << 16) | pc
+    std::map<uint32_t, Block> blocks;
+
+    [[nodiscard]] uint8_t Read(uint16_t bank, uint16_t address) const;
+    Block DecodeBlock(uint16_t bank, uint16_t pc);
+    /// Addresses execution can continue at after the last instruction of a block, in the bank they are in
+    void AddSuccessors(const Block &block, std::vector<std::pair<uint16_t, uint16_t>> &queue) const;
+    static std::string BlockName(const Block &block);
+    static std::string GenerateBlock(const Block &block);
+};
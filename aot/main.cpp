@@ -0,0 +1,86 @@
+// megaboy-aot: recompile a cartridge ROM into a shared object for the emulator.
+//
+// usage: megaboy-aot <rom.gb> [<library.so>] [--cxx <compiler>] [--keep-source]
+//
+// The library defaults to the ROM path with the extension .aot.so, which is where the debugger looks for it when loading the ROM.
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "StaticRecompiler.h"
+
+#ifndef MEGABOY_AOT_CXX
+#define MEGABOY_AOT_CXX "c++"
+#endif
+
+#ifndef MEGABOY_AOT_INCLUDE_DIR
+#define MEGABOY_AOT_INCLUDE_DIR "CPU"
+#endif
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> paths;
+    std::string compiler = MEGABOY_AOT_CXX;
+    bool keep_source = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--cxx" && i + 1 < argc)
+        {
+            compiler = argv[++i];
+        }
+        else if (arg == "--keep-source")
+        {
+            keep_source = true;
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.empty() || paths.size() > 2)
+    {
+        std::cout << "usage: megaboy-aot <rom.gb> [<library.so>] [--cxx <compiler>] [--keep-source]" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path rom_path = paths[0];
+    std::filesystem::path library_path = paths.size() > 1 ? std::filesystem::path(paths[1]) : std::filesystem::path(rom_path).replace_extension(".aot.so");
+    std::filesystem::path source_path = std::filesystem::path(library_path).replace_extension(".cpp");
+
+    std::ifstream rom_file(rom_path, std::ios::in | std::ios::binary);
+    if (!rom_file)
+    {
+        std::cout << "could not read " << rom_path << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> rom{std::istreambuf_iterator<char>(rom_file), std::istreambuf_iterator<char>()};
+
+    StaticRecompiler recompiler(std::move(rom));
+    recompiler.FindBlocks();
+    std::cout << "Found " << recompiler.BlockCount() << " blocks in " << rom_path << std::endl;
+
+    {
+        std::ofstream source_file(source_path);
+        source_file << recompiler.GenerateSource();
+    }
+
+    bool compiled = StaticRecompiler::CompileLibrary(compiler, MEGABOY_AOT_INCLUDE_DIR, source_path, library_path);
+    if (!keep_source)
+    {
+        std::filesystem::remove(source_path);
+    }
+
+    if (!compiled)
+    {
+        std::cout << "compiling " << source_path << " failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << library_path << std::endl;
+    return 0;
+}
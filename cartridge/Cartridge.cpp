@@ -2,6 +2,8 @@
 // Created by sbeam on 4/4/22.
 //
 
+#include <algorithm>
+#include <bit>
 #include <vector>
 #include <cstring>
 #include <format>
@@ -19,6 +21,7 @@ void Cartridge::Reset()
     {
         mbc->Reset();
     }
+    SwitchedROMBank();
 }
 
 uint8_t Cartridge::Read(uint16_t address)
@@ -37,7 +40,31 @@ void Cartridge::Write(uint8_t value, uint16_t address)
 {
     if (mbc)
     {
+        uint16_t previous_bank = GetROMBank();
         mbc->Write(value, address);
+        // Games often select the bank that is already mapped
+        if (GetROMBank() != previous_bank)
+        {
+            SwitchedROMBank();
+        }
+    }
+}
+
+uint16_t Cartridge::GetROMBank() const
+{
+    return mbc ? mbc->GetROMBank() & (rom_bank_count - 1) : 1;
+}
+
+const uint8_t *Cartridge::GetROMBankData(uint16_t bank) const
+{
+    return &rom[(bank & (rom_bank_count - 1)) * ROM_BANK_SIZE];
+}
+
+void Cartridge::SwitchedROMBank()
+{
+    if (didSwitchROMBank != nullptr)
+    {
+        didSwitchROMBank();
     }
 }
 
@@ -52,6 +79,7 @@ bool Cartridge::Load(uint8_t *data, long size)
         }
 
         memcpy(&header, &rom[0x100], sizeof(CartridgeHeader));
+        rom_bank_count = static_cast<uint16_t>(std::bit_ceil(static_cast<unsigned long>(std::max<long>(2, (size + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE))));
 
         if (header.cartridge_type == CartridgeType::ROM_Only)
         {
@@ -64,6 +92,7 @@ bool Cartridge::Load(uint8_t *data, long size)
             // MBC *mbc = new MBC1(rom);
         }
         is_loaded = true;
+        SwitchedROMBank();
     }
 
     return true;
@@ -12,11 +12,13 @@
 #include "CartridgeHeader.h"
 #include "MBC.h"
 #include <cassert>
+#include <functional>
 
 class Cartridge
 {
 
     constexpr static long MAXIMUM_ROM_SIZE = 1048576;
+    constexpr static long ROM_BANK_SIZE = 16384;
 
 private:
     /// The offset into the ROM reflected by the selected BANK.
@@ -26,10 +28,18 @@ private:
     // 0xa00 - 0xbfff RAM
     CartridgeHeader header;
     bool is_loaded = false;
+    /// Number of banks in the loaded ROM, rounded up to a power of two. Bank numbers wrap around at it,
+    /// as the bank number bits beyond the size of the ROM are not connected.
+    uint16_t rom_bank_count = 2;
+
+    void SwitchedROMBank();
 
 public:
     Cartridge() {}
 
+    /// Called when a different ROM bank is mapped into 0x4000 - 0x7fff, by loading, resetting or an MBC write
+    std::function<void()> didSwitchROMBank = nullptr;
+
     CartridgeHeader &GetHeader();
 
     const std::string ROMSizeString();
@@ -41,6 +51,10 @@ public:
     bool Load(uint8_t *data, long size);
     uint8_t Read(uint16_t address);
     void Write(uint8_t value, uint16_t address);
+    /// The ROM bank currently mapped into 0x4000 - 0x7fff, wrapped to the size of the ROM
+    uint16_t GetROMBank() const;
+    /// The 16 KiB of ROM in a bank, so reads from it need not go through the MBC
+    const uint8_t *GetROMBankData(uint16_t bank) const;
 };
 
 #endif // MEGABOY_CARTRIDGE_H
@@ -9,6 +9,8 @@ public:
     virtual void Reset() = 0;
     virtual void Write(uint8_t value, uint16_t address) = 0;
     virtual uint8_t Read(uint16_t address) = 0;
+    /// The ROM bank currently mapped into 0x4000 - 0x7fff
+    virtual uint16_t GetROMBank() const { return 1; };
     virtual ~MBC(){};
 
 protected:
@@ -118,4 +120,9 @@ public:
         }
         return 0;
     };
+
+    uint16_t GetROMBank() const
+    {
+        return rom_bank_number;
+    }
 };
\ No newline at end of file
@@ -290,6 +290,11 @@ Disassembler::Disassembler()
 DisassemblyLine Disassembler::DisassembleAddress(uint16_t address, const HostMemory &hostmem)
 {
     InstructionBytes bytes = {hostmem.Read(address), hostmem.Read(address + 1), hostmem.Read(address + 2)};
+    return Disassemble(bytes, address);
+}
+
+DisassemblyLine Disassembler::Disassemble(const InstructionBytes &bytes, uint16_t address)
+{
     Instruction &inst = instructions[bytes.data[0]]; // todo: bound check
     DisassemblyLine line;
 
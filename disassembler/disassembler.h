@@ -44,6 +44,11 @@ public:
     /// @return Number of bytes the instruction took up.
     DisassemblyLine DisassembleAddress(uint16_t address, const HostMemory &memref);
 
+    /// @brief Disassemble instruction bytes that are not in host memory, like a ROM bank that isn't mapped in.
+    /// @param bytes The opcode followed by up to two operand bytes.
+    /// @param address The address of the opcode, used for the PC of the line.
+    DisassemblyLine Disassemble(const InstructionBytes &bytes, uint16_t address);
+
     static std::string invalid_opcode(const InstructionBytes &bytes);
     static std::string decode_bit_instruction(const InstructionBytes &bytes);
 
@@ -115,7 +115,7 @@ int main(int, char **)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // This is required on WebGL for non power-of-two textures
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Same
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, MegaBoyDebugger::GB_SCREEN_WIDTH, MegaBoyDebugger::GB_SCREEN_HEIGHT, 0, GL_BGRA, GL_UNSIGNED_BYTE, (GLvoid *)debugger.screenData);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, MegaBoyDebugger::GB_SCREEN_WIDTH, MegaBoyDebugger::GB_SCREEN_HEIGHT, 0, GL_BGRA, GL_UNSIGNED_BYTE, (GLvoid *)debugger.ScreenData());
 
     std::map<int, Joypad::Button> button_map = {
         {SDLK_LEFT, Joypad::Button::Left},
@@ -192,7 +192,7 @@ int main(int, char **)
             ImGui::Begin("Gameboy screen:"); // Create a window called "Hello, world!" and append into it.
 
             // Update Texture
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, MegaBoyDebugger::GB_SCREEN_WIDTH, MegaBoyDebugger::GB_SCREEN_HEIGHT, GL_BGRA, GL_UNSIGNED_BYTE, (GLvoid *)debugger.screenData);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, MegaBoyDebugger::GB_SCREEN_WIDTH, MegaBoyDebugger::GB_SCREEN_HEIGHT, GL_BGRA, GL_UNSIGNED_BYTE, (GLvoid *)debugger.ScreenData());
 
             ImGui::Image((void *)(intptr_t)textureId, ImVec2(MegaBoyDebugger::GB_SCREEN_WIDTH * 2, MegaBoyDebugger::GB_SCREEN_HEIGHT * 2));
 
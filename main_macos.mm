@@ -193,7 +193,7 @@ int main(int, char**)
                 };
 
                 // Blit gameboy screen data into metal texture
-                [texture replaceRegion:region mipmapLevel:0 withBytes:debugger.screenData bytesPerRow:4*MegaBoyDebugger::GB_SCREEN_WIDTH];
+                [texture replaceRegion:region mipmapLevel:0 withBytes:debugger.ScreenData() bytesPerRow:4*MegaBoyDebugger::GB_SCREEN_WIDTH];
 
                 ImGui::Image((void*)(intptr_t)texture, ImVec2(MegaBoyDebugger::GB_SCREEN_WIDTH*2, MegaBoyDebugger::GB_SCREEN_HEIGHT*2));
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -0,0 +1,81 @@
+//
+// Benchmarks running test ROMs through the emulator.
+// These are hidden from the default test run, run them with: cputests "[benchmark]"
+//
+
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <chrono>
+
+#include "test_rom.h"
+
+namespace
+{
+    /// Number of cycles each benchmark iteration runs (~50 frames)
+    constexpr uint64_t BenchmarkCycles = 3500000;
+}
+
+TEST_CASE("CPU dispatch modes", "[.][benchmark]")
+{
+    auto rom = ReadTestRom("cpu_instrs.gb");
+    REQUIRE(!rom.empty());
+
+    // Native code runs whole blocks without going through either dispatcher, so every instruction is interpreted
+    BENCHMARK_ADVANCED("cpu_instrs.gb - table dispatch")(Catch::Benchmark::Chronometer meter)
+    {
+        auto gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+        gb->cpu.dispatch_mode = CPU::DispatchMode::Table;
+        gb->cpu.use_native_code = false;
+        meter.measure([&]
+                      { return RunTestRomCycles(*gb, BenchmarkCycles); });
+    };
+
+    BENCHMARK_ADVANCED("cpu_instrs.gb - switch dispatch")(Catch::Benchmark::Chronometer meter)
+    {
+        auto gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+        gb->cpu.dispatch_mode = CPU::DispatchMode::Switch;
+        gb->cpu.use_native_code = false;
+        meter.measure([&]
+                      { return RunTestRomCycles(*gb, BenchmarkCycles); });
+    };
+}
+
+TEST_CASE("Frame skipping", "[.][benchmark]")
+{
+    auto rom = ReadTestRom("dmg-acid2.gb");
+    REQUIRE(!rom.empty());
+
+    // dmg-acid2 draws a static screen after the boot ROM and waits, so most of the time of a frame is drawing it.
+    auto gb = MakeGameboyWithTestRom("dmg-acid2.gb");
+    RunTestRomCycles(*gb, 320 * Gameboy::CyclesPerFrame);
+
+    for (auto [drawn, period] : {std::pair{1, 1}, std::pair{1, 4}, std::pair{0, 1}})
+    {
+        BENCHMARK_ADVANCED("dmg-acid2.gb - " + std::to_string(drawn) + " of " + std::to_string(period) + " frames drawn")(Catch::Benchmark::Chronometer meter)
+        {
+            gb->lcd.frames_drawn_per_period = drawn;
+            gb->lcd.frame_skip_period = period;
+            meter.measure([&]
+                          { return RunTestRomCycles(*gb, BenchmarkCycles); });
+        };
+    }
+
+    // The speedup of skipping frames is the time with every frame drawn over the time with frames skipped,
+    // each the fastest of a few runs so other work on the machine doesn't skew it
+    auto fastest_run = [&](uint32_t drawn, uint32_t period)
+    {
+        gb->lcd.frames_drawn_per_period = drawn;
+        gb->lcd.frame_skip_period = period;
+        auto fastest = std::chrono::steady_clock::duration::max();
+        for (int run = 0; run < 20; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            RunTestRomCycles(*gb, BenchmarkCycles);
+            fastest = std::min(fastest, std::chrono::steady_clock::now() - start);
+        }
+        return std::chrono::duration<double>(fastest).count();
+    };
+    double all_drawn = fastest_run(1, 1);
+    WARN("Drawing 1 of 4 frames runs " << all_drawn / fastest_run(1, 4) << "x as fast as drawing all of them");
+    WARN("Drawing no frames runs " << all_drawn / fastest_run(0, 1) << "x as fast as drawing all of them");
+}
@@ -2,6 +2,8 @@
 #include <fstream>
 
 #include "../CPU/cpu.h"
+#include "test_rom.h"
+#include "../aot/StaticRecompiler.h"
 
 TEST_CASE("fetchxxBitValue")
 {
@@ -77,6 +79,56 @@ TEST_CASE("LD r,n")
 //     REQUIRE(cpu.regs.B == 0xf0);
 // }
 
+TEST_CASE("CB opcode table")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    CPU cpu{mem};
+    cpu.reset();
+
+    auto step_cb = [&](uint8_t op2) {
+        cpu.regs.PC = 0xc000;
+        cpu.mem.Write(0xc000, 0xcb);
+        cpu.mem.Write(0xc001, op2);
+        return cpu.step();
+    };
+
+    // SWAP B
+    cpu.regs.B = 0x0f;
+    REQUIRE(step_cb(0x30) == 8);
+    REQUIRE(cpu.regs.B == 0xf0);
+    REQUIRE(cpu.regs.PC == 0xc002);
+
+    // RLC (HL)
+    cpu.regs.HL = 0xc100;
+    cpu.mem.Write(0xc100, 0x81);
+    REQUIRE(step_cb(0x06) == 16);
+    REQUIRE(cpu.mem.Read(0xc100) == 0x03);
+    REQUIRE(cpu.getFlag(FlagBitmaskC));
+
+    // BIT 7,H
+    cpu.regs.H = 0x7f;
+    REQUIRE(step_cb(0x7c) == 8);
+    REQUIRE(cpu.getFlag(FlagBitmaskZero));
+
+    // BIT 0,(HL)
+    cpu.regs.HL = 0xc100;
+    REQUIRE(step_cb(0x46) == 12);
+    REQUIRE(!cpu.getFlag(FlagBitmaskZero));
+
+    // RES 0,A and SET 7,A
+    cpu.regs.A = 0x01;
+    REQUIRE(step_cb(0x87) == 8);
+    REQUIRE(step_cb(0xff) == 8);
+    REQUIRE(cpu.regs.A == 0x80);
+
+    // SRA keeps bit 7
+    cpu.regs.C = 0x81;
+    step_cb(0x29);
+    REQUIRE(cpu.regs.C == 0xc0);
+    REQUIRE(cpu.getFlag(FlagBitmaskC));
+}
+
 TEST_CASE("RRA")
 {
     Cartridge cart;
@@ -239,3 +291,231 @@ TEST_CASE("Parity"){
     REQUIRE( cpu.has_parity(0b11111111) );
     
 }
+
+TEST_CASE("Switch and table dispatch execute cpu_instrs.gb identically")
+{
+    auto table_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    auto switch_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    table_gb->cpu.dispatch_mode = CPU::DispatchMode::Table;
+    switch_gb->cpu.dispatch_mode = CPU::DispatchMode::Switch;
+
+    constexpr uint64_t cycles = 10000000;
+    REQUIRE(RunTestRomCycles(*table_gb, cycles) == RunTestRomCycles(*switch_gb, cycles));
+    RequireSameRegisters(*table_gb, *switch_gb);
+}
+
+TEST_CASE("Block cache executes cpu_instrs.gb identically")
+{
+    auto cached_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    auto uncached_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    uncached_gb->cpu.use_block_cache = false;
+#ifdef MEGABOY_JIT
+    cached_gb->cpu.use_native_code = false;
+#endif
+
+    constexpr uint64_t cycles = 10000000;
+    REQUIRE(RunTestRomCycles(*cached_gb, cycles) == RunTestRomCycles(*uncached_gb, cycles));
+    RequireSameRegisters(*cached_gb, *uncached_gb);
+    REQUIRE(cached_gb->cpu.block_cache.decoded_blocks > 0);
+}
+
+TEST_CASE("Lazy and eager flags execute cpu_instrs.gb identically")
+{
+    auto lazy_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    auto eager_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    eager_gb->cpu.use_lazy_flags = false;
+
+    constexpr uint64_t cycles = 40000000;
+    REQUIRE(RunTestRomCycles(*lazy_gb, cycles) == RunTestRomCycles(*eager_gb, cycles));
+    RequireSameRegisters(*lazy_gb, *eager_gb);
+}
+
+TEST_CASE("Lazy and eager flags pass the cpu_instrs test ROMs")
+{
+    for (const char *rom : CpuInstrsTestRoms)
+    {
+        for (bool use_lazy_flags : {true, false})
+        {
+            INFO(rom << (use_lazy_flags ? " with lazy flags" : " with eager flags"));
+            auto gb = MakeGameboyWithTestRom(rom);
+            gb->cpu.use_lazy_flags = use_lazy_flags;
+#if defined(MEGABOY_JIT) || defined(MEGABOY_AOT)
+            // Native code computes the flags itself, so interpret every instruction
+            gb->cpu.use_native_code = false;
+#endif
+
+            std::string output = RunTestRomToVerdict(*gb, 150000000);
+            REQUIRE(output.find("Passed") != std::string::npos);
+        }
+    }
+}
+
+TEST_CASE("HALT fast-forward runs 02-interrupts.gb identically")
+{
+    auto fast_gb = MakeGameboyWithTestRom("02-interrupts.gb");
+    auto stepped_gb = MakeGameboyWithTestRom("02-interrupts.gb");
+    stepped_gb->use_halt_fast_forward = false;
+
+    uint64_t fast_steps = 0;
+    uint64_t cycles = 0;
+    while (cycles < 30000000)
+    {
+        cycles += fast_gb->Step();
+        fast_steps++;
+    }
+
+    // Fast-forwarding stops at the same cycles a cycle-by-cycle HALT would be woken up at
+    uint64_t stepped_steps = 0;
+    uint64_t stepped_cycles = 0;
+    while (stepped_cycles < cycles)
+    {
+        stepped_cycles += stepped_gb->Step();
+        stepped_steps++;
+    }
+    REQUIRE(stepped_cycles == cycles);
+    REQUIRE(fast_steps < stepped_steps);
+
+    RequireSameRegisters(*fast_gb, *stepped_gb);
+    REQUIRE(fast_gb->timer.GetDividerRegister() == stepped_gb->timer.GetDividerRegister());
+    REQUIRE(fast_gb->timer.GetCounter() == stepped_gb->timer.GetCounter());
+}
+
+TEST_CASE("Idle loop skipping runs cpu_instrs.gb identically")
+{
+    auto skipping_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    auto stepped_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    stepped_gb->cpu.use_idle_loop_skipping = false;
+#if defined(MEGABOY_JIT) || defined(MEGABOY_AOT)
+    skipping_gb->cpu.use_native_code = false;
+    stepped_gb->cpu.use_native_code = false;
+#endif
+
+    // The boot ROM waits for VBlank polling LY. Skipped passes end at the same cycles the polling would, so run the other up to the exact same cycle.
+    uint64_t cycles = RunTestRomCycles(*skipping_gb, 30000000);
+    REQUIRE(RunTestRomCycles(*stepped_gb, cycles) == cycles);
+
+    RequireSameRegisters(*skipping_gb, *stepped_gb);
+    REQUIRE(skipping_gb->cpu.idle_loop.detected_loops > 0);
+    REQUIRE(skipping_gb->cpu.idle_loop.skipped_iterations > 0);
+    REQUIRE(stepped_gb->cpu.idle_loop.skipped_iterations == 0);
+}
+
+#ifdef MEGABOY_JIT
+TEST_CASE("JIT executes cpu_instrs.gb identically")
+{
+    auto jit_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    auto interpreted_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    interpreted_gb->cpu.use_native_code = false;
+
+    // The boot ROM takes about 21M cycles. Native code runs whole blocks per step, so run the interpreter up to the exact same cycle
+    uint64_t cycles = RunTestRomCycles(*jit_gb, 40000000);
+    REQUIRE(RunTestRomCycles(*interpreted_gb, cycles) == cycles);
+    RequireSameRegisters(*jit_gb, *interpreted_gb);
+    REQUIRE(jit_gb->cpu.jit.compiled_blocks > 0);
+}
+
+TEST_CASE("JIT passes the cpu_instrs test ROMs")
+{
+    for (const char *rom : CpuInstrsTestRoms)
+    {
+        INFO(rom);
+        auto gb = MakeGameboyWithTestRom(rom);
+        REQUIRE(gb->cpu.use_native_code);
+
+        std::string output = RunTestRomToVerdict(*gb, 150000000);
+        REQUIRE(output.find("Passed") != std::string::npos);
+        REQUIRE(gb->cpu.jit.compiled_blocks > 0);
+    }
+}
+#endif
+
+#ifdef MEGABOY_AOT
+/// Recompile a test ROM ahead of time into a shared object in the temp directory
+/// \return path of the shared object
+static std::filesystem::path RecompileTestRom(const std::string &rom, StaticRecompiler &recompiler)
+{
+    recompiler.FindBlocks();
+    REQUIRE(recompiler.BlockCount() > 0);
+
+    auto directory = std::filesystem::temp_directory_path() / "megaboy_aot_test";
+    std::filesystem::create_directories(directory);
+    auto name = std::filesystem::path(rom).stem().string();
+    auto source = directory / (name + ".aot.cpp");
+    auto library = directory / (name + ".aot.so");
+    {
+        std::ofstream source_file(source);
+        source_file << recompiler.GenerateSource();
+    }
+    REQUIRE(StaticRecompiler::CompileLibrary(MEGABOY_AOT_CXX, MEGABOY_AOT_INCLUDE_DIR, source, library));
+    return library;
+}
+
+TEST_CASE("AOT recompiled cpu_instrs.gb runs identically")
+{
+    StaticRecompiler recompiler(ReadTestRom("cpu_instrs.gb"));
+    auto library = RecompileTestRom("cpu_instrs.gb", recompiler);
+
+    auto aot_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    auto interpreted_gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+    interpreted_gb->cpu.use_native_code = false;
+    REQUIRE(aot_gb->cpu.aot.Load(library.string(), aot_gb->cartridge.GetHeader()));
+    REQUIRE(aot_gb->cpu.aot.BlockCount() == recompiler.BlockCount());
+    aot_gb->cpu.reset();
+
+    // The boot ROM takes about 21M cycles. Native code runs whole blocks per step, so run the interpreter up to the exact same cycle
+    uint64_t cycles = RunTestRomCycles(*aot_gb, 40000000);
+    REQUIRE(RunTestRomCycles(*interpreted_gb, cycles) == cycles);
+    RequireSameRegisters(*aot_gb, *interpreted_gb);
+    REQUIRE(aot_gb->cpu.aot.attached_blocks > 0);
+
+    // A library built from another ROM is rejected
+    auto other_gb = MakeGameboyWithTestRom("halt_bug.gb");
+    REQUIRE_FALSE(other_gb->cpu.aot.Load(library.string(), other_gb->cartridge.GetHeader()));
+}
+
+TEST_CASE("AOT recompiled cpu_instrs test ROMs pass")
+{
+    for (const char *rom : CpuInstrsTestRoms)
+    {
+        INFO(rom);
+        StaticRecompiler recompiler(ReadTestRom(rom));
+        auto library = RecompileTestRom(rom, recompiler);
+
+        auto gb = MakeGameboyWithTestRom(rom);
+        REQUIRE(gb->cpu.aot.Load(library.string(), gb->cartridge.GetHeader()));
+        gb->cpu.reset();
+
+        std::string output = RunTestRomToVerdict(*gb, 150000000);
+        REQUIRE(output.find("Passed") != std::string::npos);
+        REQUIRE(gb->cpu.aot.attached_blocks > 0);
+    }
+}
+#endif
+
+TEST_CASE("Block cache drops modified RAM code")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    CPU cpu{mem};
+    cpu.reset();
+
+    // LD A,0x11
+    cpu.mem.Write(0xc000, 0x3e);
+    cpu.mem.Write(0xc001, 0x11);
+    cpu.regs.PC = 0xc000;
+    cpu.step();
+    REQUIRE(cpu.regs.A == 0x11);
+
+    // Same code again is taken from the cache
+    cpu.regs.PC = 0xc000;
+    cpu.step();
+    REQUIRE(cpu.block_cache.decoded_blocks == 1);
+
+    // LD A,0x22
+    cpu.mem.Write(0xc001, 0x22);
+    cpu.regs.PC = 0xc000;
+    cpu.step();
+    REQUIRE(cpu.regs.A == 0x22);
+    REQUIRE(cpu.regs.PC == 0xc002);
+    REQUIRE(cpu.block_cache.decoded_blocks == 2);
+}
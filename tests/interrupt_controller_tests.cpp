@@ -0,0 +1,49 @@
+#include <catch2/catch_all.hpp>
+
+#include "../Gameboy.h"
+
+TEST_CASE("Interrupt controller keeps the pending interrupts")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    InterruptController &interrupts = mem.interrupts;
+
+    mem.SetInterruptFlag(Interrupt_Flag_Timer, true);
+    REQUIRE(interrupts.Pending() == 0);
+    REQUIRE(mem.Read(IOAddress::InterruptFlag) == Interrupt_Flag_Timer);
+
+    mem.Write(IOAddress::InterruptEnabled, 0xff);
+    REQUIRE(interrupts.Pending() == Interrupt_Flag_Timer);
+    REQUIRE(interrupts.NextInterrupt() == 2);
+
+    // VBlank has the highest priority
+    mem.SetInterruptFlag(Interrupt_Flag_Joypad, true);
+    mem.SetInterruptFlag(Interrupt_Flag_VBlank, true);
+    REQUIRE(interrupts.NextInterrupt() == 0);
+
+    mem.SetInterruptFlag(Interrupt_Flag_VBlank, false);
+    REQUIRE(interrupts.Pending() == (Interrupt_Flag_Timer | Interrupt_Flag_Joypad));
+
+    // Only the five interrupt bits can be pending
+    mem.Write(IOAddress::InterruptFlag, 0xe0);
+    REQUIRE(mem.Read(IOAddress::InterruptFlag) == 0xe0);
+    REQUIRE(interrupts.Pending() == 0);
+}
+
+TEST_CASE("Interrupts are dispatched to their vector by priority")
+{
+    Gameboy gb;
+    gb.cpu.reset();
+    gb.cpu.regs.PC = 0x1234;
+    gb.cpu.regs.SP = 0xd000;
+    gb.cpu.interrupt_master_enabled = true;
+
+    gb.mem.Write(IOAddress::InterruptEnabled, Interrupt_Flag_LCD_Stat | Interrupt_Flag_Serial);
+    gb.mem.Write(IOAddress::InterruptFlag, Interrupt_Flag_Serial | Interrupt_Flag_LCD_Stat | Interrupt_Flag_VBlank);
+    gb.HandleInterrupts();
+
+    REQUIRE(gb.cpu.regs.PC == 0x48);
+    REQUIRE(gb.cpu.regs.SP == 0xcffe);
+    REQUIRE_FALSE(gb.cpu.interrupt_master_enabled);
+    REQUIRE(gb.mem.Read(IOAddress::InterruptFlag) == (Interrupt_Flag_Serial | Interrupt_Flag_VBlank));
+}
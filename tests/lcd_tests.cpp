@@ -3,10 +3,26 @@
 //
 
 #include <catch2/catch_all.hpp>
+#include <algorithm>
 #include <fstream>
+#include <vector>
 
 #include "../CPU/cpu.h"
 #include "../LCD/lcd.h"
+#include "test_rom.h"
+
+/// The same pseudo random bytes on every run, to feed the SIMD kernels and their portable versions
+static std::vector<uint8_t> RandomBytes(size_t count)
+{
+    std::vector<uint8_t> bytes(count);
+    uint32_t seed = 1;
+    for (uint8_t &byte : bytes)
+    {
+        seed = seed * 1103515245 + 12345;
+        byte = seed >> 16;
+    }
+    return bytes;
+}
 
 TEST_CASE("LCD_Control_Register flags")
 {
@@ -96,4 +112,478 @@ TEST_CASE("DrawTile")
     REQUIRE(lcd.renderBuffer[LCD::BUFFER_WIDTH*3 + 4] == 3);
 
 }
- */
\ No newline at end of file
+ */
+/// Step a Gameboy with all STAT interrupt sources enabled, counting the LCD interrupts it requests
+static uint64_t StepCountingLCDInterrupts(Gameboy &gb, uint64_t &interrupts)
+{
+    uint16_t cycles = gb.Step();
+    interrupts += std::popcount(static_cast<uint8_t>(gb.mem.interrupts.GetInterruptFlags() & (Interrupt_Flag_VBlank | Interrupt_Flag_LCD_Stat)));
+    gb.mem.interrupts.SetInterruptFlags(0);
+    return cycles;
+}
+
+TEST_CASE("Gameboys stepped in turns draw the same frames as alone")
+{
+    // The boot ROM with no cartridge scrolls in the logo and then waits with the LCD on.
+    // The second instance starts half a frame later, so the two are never on the same line or in the same mode.
+    constexpr uint64_t Cycles = 20 * 70224;
+    constexpr uint64_t Offset = 70224 / 2;
+
+    std::unique_ptr<Gameboy> gameboys[3];
+    uint64_t cycles[3] = {};
+    uint64_t interrupts[3] = {};
+    for (auto &gb : gameboys)
+    {
+        gb = std::make_unique<Gameboy>();
+        gb->cpu.reset();
+        // Interrupts are counted instead of dispatched
+        gb->mem.Write(LCD::LCD_Stat_Register, 0b01111000);
+    }
+
+    Gameboy &solo = *gameboys[0];
+    while (cycles[0] < Cycles)
+    {
+        cycles[0] += StepCountingLCDInterrupts(solo, interrupts[0]);
+    }
+
+    while (cycles[1] < Offset)
+    {
+        cycles[1] += StepCountingLCDInterrupts(*gameboys[1], interrupts[1]);
+    }
+    while (cycles[1] < Cycles + Offset || cycles[2] < Cycles)
+    {
+        if (cycles[1] < Cycles + Offset)
+        {
+            cycles[1] += StepCountingLCDInterrupts(*gameboys[1], interrupts[1]);
+        }
+        if (cycles[2] < Cycles)
+        {
+            cycles[2] += StepCountingLCDInterrupts(*gameboys[2], interrupts[2]);
+        }
+    }
+
+    // The first instance ran half a frame longer
+    uint64_t solo_interrupts = interrupts[0];
+    while (cycles[0] < Cycles + Offset)
+    {
+        cycles[0] += StepCountingLCDInterrupts(solo, interrupts[0]);
+    }
+
+    REQUIRE(interrupts[1] == interrupts[0]);
+    REQUIRE(interrupts[2] == solo_interrupts);
+    REQUIRE(std::equal(std::begin(solo.lcd.renderBuffer), std::end(solo.lcd.renderBuffer), std::begin(gameboys[1]->lcd.renderBuffer)));
+}
+
+TEST_CASE("Skipped frames are timed the same as drawn ones and leave the last frame drawn")
+{
+    // dmg-acid2 draws sprites, the window and the background, after the boot ROM scrolled in the logo
+    auto drawn = MakeGameboyWithTestRom("dmg-acid2.gb");
+    auto skipping = MakeGameboyWithTestRom("dmg-acid2.gb");
+    skipping->lcd.frames_drawn_per_period = 1;
+    skipping->lcd.frame_skip_period = 3;
+
+    int frames_drawn = 0;
+    int frames_skipped = 0;
+    for (int frame = 0; frame < 320; frame++)
+    {
+        // Every 7th frame is skipped through RunFrame on top of that
+        bool draw = frame % 7 != 0;
+        // Only frames run from start to end are checked, not the ones cut short by the LCD being turned on or off
+        bool whole_frame = skipping->lcd.IsEnabled() && skipping->lcd.current_scanline == 144;
+        uint64_t frame_count = skipping->lcd.frame_count;
+        memset(skipping->lcd.renderBuffer, 0xff, sizeof(skipping->lcd.renderBuffer));
+
+        REQUIRE(skipping->RunFrame(draw) == drawn->RunFrame());
+        REQUIRE(skipping->lcd.frame_count == drawn->lcd.frame_count);
+        REQUIRE(skipping->lcd.current_scanline == drawn->lcd.current_scanline);
+        REQUIRE(skipping->lcd.ReadStatRegister() == drawn->lcd.ReadStatRegister());
+        REQUIRE(skipping->mem.interrupts.GetInterruptFlags() == drawn->mem.interrupts.GetInterruptFlags());
+        REQUIRE(skipping->cpu.regs.PC == drawn->cpu.regs.PC);
+
+        if (!whole_frame || skipping->lcd.frame_count != frame_count + 1)
+        {
+            continue;
+        }
+        if (draw && frame_count % 3 == 0)
+        {
+            frames_drawn++;
+            REQUIRE(std::equal(std::begin(skipping->lcd.renderBuffer), std::end(skipping->lcd.renderBuffer), std::begin(drawn->lcd.renderBuffer)));
+        }
+        else
+        {
+            frames_skipped++;
+            REQUIRE(std::all_of(std::begin(skipping->lcd.renderBuffer), std::end(skipping->lcd.renderBuffer), [](uint8_t pixel)
+                                { return pixel == 0xff; }));
+        }
+    }
+    REQUIRE(frames_drawn > 50);
+    REQUIRE(frames_skipped > 100);
+}
+
+TEST_CASE("A frame skip period of 0 draws every frame")
+{
+    auto gb = MakeGameboyWithTestRom("dmg-acid2.gb");
+    gb->lcd.frame_skip_period = 0;
+    for (int frame = 0; frame < 320; frame++)
+    {
+        gb->RunFrame();
+    }
+    REQUIRE(gb->lcd.frame_count > 0);
+    REQUIRE(std::any_of(std::begin(gb->lcd.renderBuffer), std::end(gb->lcd.renderBuffer), [](uint8_t pixel)
+                        { return pixel != 0; }));
+}
+
+TEST_CASE("The LCD is only stepped at mode and scanline changes, and stops while turned off")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    LCD lcd(mem);
+
+    REQUIRE(!lcd.IsEnabled());
+    mem[LCD::LCD_Control_Register] = static_cast<uint8_t>(LCDCBitmask::LCD_enabled);
+    lcd.RegistersWritten();
+    REQUIRE(lcd.IsEnabled());
+
+    // Modes 2, 3 and 0 on the visible lines, then one event per line of VBlank
+    uint32_t cycles = 0;
+    uint32_t events = 0;
+    while (!(mem.interrupts.GetInterruptFlags() & Interrupt_Flag_VBlank))
+    {
+        cycles += lcd.CyclesUntilNextEvent();
+        lcd.Step();
+        events++;
+    }
+    REQUIRE(cycles == 144 * LCD::CyclesPerScanline);
+    REQUIRE(events == 144 * 3);
+    REQUIRE(lcd.current_scanline == 144);
+    REQUIRE((lcd.ReadStatRegister() & 0b11) == 1);
+
+    while (lcd.current_scanline != 0)
+    {
+        cycles += lcd.CyclesUntilNextEvent();
+        lcd.Step();
+        events++;
+    }
+    REQUIRE(cycles == 154 * LCD::CyclesPerScanline);
+    REQUIRE(events == 144 * 3 + 10);
+
+    for (int i = 0; i < 5; i++)
+    {
+        lcd.Step();
+    }
+    mem[LCD::LCD_Control_Register] = 0;
+    lcd.RegistersWritten();
+    REQUIRE(!lcd.IsEnabled());
+    REQUIRE(lcd.current_scanline == 0);
+    REQUIRE((lcd.ReadStatRegister() & 0b11) == 0);
+}
+
+TEST_CASE("Sprites are drawn in priority order, at most 10 per line, and sorted onto lines again after OAM is written")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    LCD lcd(mem);
+
+    // Tile 1 is all color 1, tile 2 all color 3
+    for (int row = 0; row < 8; row++)
+    {
+        mem.Write(0x8010 + row * 2, 0xff);
+        mem.Write(0x8020 + row * 2, 0xff);
+        mem.Write(0x8020 + row * 2 + 1, 0xff);
+    }
+    auto set_sprite = [&mem](int index, uint8_t y, uint8_t x, uint8_t tile)
+    {
+        mem.Write(0xfe00 + index * 4, y);
+        mem.Write(0xfe00 + index * 4 + 1, x);
+        mem.Write(0xfe00 + index * 4 + 2, tile);
+        mem.Write(0xfe00 + index * 4 + 3, 0);
+    };
+    // At the same X the sprite first in OAM is on top
+    set_sprite(0, 16, 8, 1);
+    set_sprite(1, 16, 8, 2);
+    // Otherwise the sprite with the lower X
+    set_sprite(2, 16, 36, 1);
+    set_sprite(3, 16, 32, 2);
+    // Sprite 10 is the 11th on the line
+    for (int index = 4; index <= 10; index++)
+    {
+        set_sprite(index, 16, 50 + index * 8, 1);
+    }
+
+    mem.Write(LCD::LCD_Control_Register, static_cast<uint8_t>(LCDCBitmask::LCD_enabled) | static_cast<uint8_t>(LCDCBitmask::OBJ_Enable));
+    lcd.RegistersWritten();
+    // Mode 2 to 3 draws line 0
+    lcd.Step();
+    REQUIRE(lcd.renderBuffer[0] == (PaletteTag_OBJ0 | 1));
+    REQUIRE(lcd.renderBuffer[7] == (PaletteTag_OBJ0 | 1));
+    REQUIRE(lcd.renderBuffer[28] == (PaletteTag_OBJ0 | 3));
+    REQUIRE(lcd.renderBuffer[32] == (PaletteTag_OBJ0 | 1));
+    REQUIRE(lcd.renderBuffer[114] == (PaletteTag_OBJ0 | 1));
+    REQUIRE(lcd.renderBuffer[122] == 0);
+
+    // Hide sprite 0, making room for sprite 10, and draw line 1
+    mem.Write(0xfe00, 0);
+    lcd.Step();
+    lcd.Step();
+    lcd.Step();
+    REQUIRE(lcd.current_scanline == 1);
+    REQUIRE(lcd.renderBuffer[LCD::BUFFER_WIDTH] == (PaletteTag_OBJ0 | 3));
+    REQUIRE(lcd.renderBuffer[LCD::BUFFER_WIDTH + 122] == (PaletteTag_OBJ0 | 1));
+}
+
+TEST_CASE("Compositor resolves sprite priority before BG priority, and its kernels merge lines identically")
+{
+    ScanlineCompositor compositor;
+    const uint8_t color_1[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+    const uint8_t color_3_left_half[8] = {3, 3, 3, 3, 0, 0, 0, 0};
+
+    // The sprite drawn last wins its opaque pixels, whether or not it is behind the background
+    compositor.ClearObjects();
+    compositor.DrawObjectRow(color_1, -4, PaletteTag_OBJ0, false);
+    compositor.DrawObjectRow(color_3_left_half, -2, PaletteTag_OBJ1, true);
+    compositor.DrawObjectRow(color_1, 248, PaletteTag_OBJ1, false);
+
+    uint8_t line[ScanlineCompositor::LineWidth] = {};
+    line[0] = 2;
+    line[4] = 1;
+    compositor.Composite(line);
+    // Behind BG color 2, and the sprite under it doesn't show either
+    REQUIRE(line[0] == 2);
+    // In front of BG color 0
+    REQUIRE(line[1] == (PaletteTag_OBJ1 | 3));
+    // Transparent pixels show the sprite drawn before
+    REQUIRE(line[2] == (PaletteTag_OBJ0 | 1));
+    REQUIRE(line[3] == (PaletteTag_OBJ0 | 1));
+    REQUIRE(line[4] == 1);
+    REQUIRE(line[255] == (PaletteTag_OBJ1 | 1));
+
+    uint8_t bg[ScanlineCompositor::LineWidth];
+    uint8_t objects[ScanlineCompositor::LineWidth];
+    uint8_t behind_bg[ScanlineCompositor::LineWidth];
+    auto random_bytes = RandomBytes(ScanlineCompositor::LineWidth);
+    for (int i = 0; i < ScanlineCompositor::LineWidth; i++)
+    {
+        uint8_t object_color = (random_bytes[i] >> 2) & 0b11;
+        bg[i] = random_bytes[i] & 0b11;
+        objects[i] = object_color ? PaletteTag_OBJ0 | object_color : 0;
+        behind_bg[i] = (random_bytes[i] >> 4) & 1 ? 0xff : 0;
+    }
+
+    uint8_t expected[ScanlineCompositor::LineWidth];
+    memcpy(expected, bg, sizeof(bg));
+    ScanlineCompositor::Composite(ScanlineCompositor::Kernel::Portable, expected, objects, behind_bg, ScanlineCompositor::LineWidth);
+    for (int i = 0; i < ScanlineCompositor::LineWidth; i++)
+    {
+        bool shows_obj = objects[i] != 0 && !(behind_bg[i] && bg[i] != 0);
+        REQUIRE(expected[i] == (shows_obj ? objects[i] : bg[i]));
+    }
+
+    for (auto kernel : {ScanlineCompositor::Kernel::SSE2, ScanlineCompositor::Kernel::AVX2})
+    {
+        if (!ScanlineCompositor::IsSupported(kernel))
+        {
+            continue;
+        }
+        memcpy(line, bg, sizeof(bg));
+        ScanlineCompositor::Composite(kernel, line, objects, behind_bg, ScanlineCompositor::LineWidth);
+        REQUIRE(memcmp(line, expected, sizeof(line)) == 0);
+    }
+}
+
+TEST_CASE("Tile cache decodes tiles again after they are written")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    TileCache tile_cache(mem);
+
+    // Row 0 of tile 1, with the colors 0, 1, 2, 3 twice
+    mem.Write(0x8010, 0b01010101); // LSB
+    mem.Write(0x8011, 0b00110011); // MSB
+    const uint8_t *pixels = tile_cache.GetRow(0x8010);
+    REQUIRE(std::vector<uint8_t>(pixels, pixels + 8) == std::vector<uint8_t>{0, 1, 2, 3, 0, 1, 2, 3});
+    REQUIRE(!mem.modified_tiles[1]);
+
+    mem.Write(0x8011, 0);
+    REQUIRE(mem.modified_tiles[1]);
+    pixels = tile_cache.GetRow(0x8010);
+    REQUIRE(std::vector<uint8_t>(pixels, pixels + 8) == std::vector<uint8_t>{0, 1, 0, 1, 0, 1, 0, 1});
+
+    // Last row of the last tile
+    mem.Write(0x97ff, 0xff);
+    REQUIRE(tile_cache.GetRow(0x97fe)[7] == 2);
+}
+
+TEST_CASE("Background layer draws tiles again after their map entry or tile data is written")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    TileCache tile_cache(mem);
+    BackgroundLayer layer(mem, tile_cache, 0x9800);
+    uint8_t line[BackgroundLayer::Size];
+
+    // Tile 1 is all color 1, tile 0 and the signed tile 0 (0x9000) all color 2
+    for (int row = 0; row < 8; row++)
+    {
+        mem.Write(0x8010 + row * 2, 0xff);
+        mem.Write(0x8000 + row * 2 + 1, 0xff);
+        mem.Write(0x9000 + row * 2 + 1, 0xff);
+    }
+    // Map entry (1, 2) is tile 1, the rest tile 0
+    mem.Write(0x9800 + 2 * 32 + 1, 1);
+
+    layer.CopyLine(2 * 8 + 3, 0, true, line);
+    REQUIRE(line[7] == 2);
+    REQUIRE(line[8] == 1);
+    REQUIRE(line[15] == 1);
+    REQUIRE(line[16] == 2);
+
+    // Scrolled lines wrap around at the right edge
+    layer.CopyLine(2 * 8 + 3, 12, true, line);
+    REQUIRE(line[0] == 1);
+    REQUIRE(line[4] == 2);
+    REQUIRE(line[243] == 2);
+    REQUIRE(line[252] == 1);
+    layer.CopyLine(2 * 8 + 3, 252, true, line);
+    REQUIRE(line[12] == 1);
+
+    // Map writes
+    mem.Write(0x9800 + 2 * 32 + 1, 0);
+    layer.CopyLine(2 * 8 + 3, 0, true, line);
+    REQUIRE(line[8] == 2);
+
+    // Tile data writes
+    mem.Write(0x8000 + 3 * 2, 0xff);
+    layer.CopyLine(2 * 8 + 3, 0, true, line);
+    REQUIRE(line[8] == 3);
+    REQUIRE(line[100] == 3);
+
+    // Signed tile data addressing
+    layer.CopyLine(2 * 8 + 3, 0, false, line);
+    REQUIRE(line[8] == 2);
+}
+
+TEST_CASE("Tile decoders supported by the CPU decode tiles identically")
+{
+    auto random_bytes = RandomBytes(256 * 16);
+    for (int tile = 0; tile < 256; tile++)
+    {
+        const uint8_t *tile_data = &random_bytes[tile * 16];
+
+        uint8_t expected[64];
+        uint8_t expected_flipped[64];
+        TileCache::DecodeTile(TileCache::Decoder::Portable, tile_data, expected, expected_flipped);
+
+        // Row 3, bit 7 is the leftmost pixel
+        REQUIRE(expected[3 * 8] == (((tile_data[6] >> 7) & 1) | (((tile_data[7] >> 7) & 1) << 1)));
+        REQUIRE(expected_flipped[3 * 8 + 7] == expected[3 * 8]);
+
+        for (auto decoder : {TileCache::Decoder::BMI2, TileCache::Decoder::SSE2, TileCache::Decoder::AVX2})
+        {
+            if (!TileCache::IsSupported(decoder))
+            {
+                continue;
+            }
+            uint8_t pixels[64];
+            uint8_t flipped_pixels[64];
+            TileCache::DecodeTile(decoder, tile_data, pixels, flipped_pixels);
+            REQUIRE(memcmp(pixels, expected, sizeof(pixels)) == 0);
+            REQUIRE(memcmp(flipped_pixels, expected_flipped, sizeof(flipped_pixels)) == 0);
+        }
+    }
+}
+
+TEST_CASE("Palette kernels supported by the CPU map pixels identically")
+{
+    PaletteMapper mapper;
+    // BGP maps colors in order, OBP0 in reverse and OBP1 all to black
+    mapper.SetPalettes(0b11100100, 0b00011011, 0b11111111);
+    REQUIRE(mapper.colors[0] == 0xffffffff);
+    REQUIRE(mapper.colors[3] == 0xff000000);
+    REQUIRE(mapper.colors[PaletteTag_OBJ0 | 0] == 0xff000000);
+    REQUIRE(mapper.colors[PaletteTag_OBJ0 | 2] == 0xffaaaaaa);
+    REQUIRE(mapper.colors[PaletteTag_OBJ1 | 1] == 0xff000000);
+
+    // Colors 0-3 of the BG, OBP0 or OBP1 palette
+    uint8_t pixels[LCD::BUFFER_WIDTH];
+    auto random_bytes = RandomBytes(LCD::BUFFER_WIDTH);
+    for (int i = 0; i < LCD::BUFFER_WIDTH; i++)
+    {
+        pixels[i] = (random_bytes[i] % 3) << 2 | (random_bytes[i] >> 6);
+    }
+
+    uint32_t expected[LCD::BUFFER_WIDTH];
+    PaletteMapper::Map(PaletteMapper::Kernel::Portable, mapper.colors, 4, pixels, reinterpret_cast<uint8_t *>(expected), LCD::BUFFER_WIDTH);
+    for (int i = 0; i < LCD::BUFFER_WIDTH; i++)
+    {
+        REQUIRE(expected[i] == mapper.colors[pixels[i]]);
+    }
+
+    for (auto kernel : {PaletteMapper::Kernel::SSSE3, PaletteMapper::Kernel::AVX2})
+    {
+        if (!PaletteMapper::IsSupported(kernel))
+        {
+            continue;
+        }
+        uint32_t rgba[LCD::BUFFER_WIDTH];
+        PaletteMapper::Map(kernel, mapper.colors, 4, pixels, reinterpret_cast<uint8_t *>(rgba), LCD::BUFFER_WIDTH);
+        REQUIRE(memcmp(rgba, expected, sizeof(rgba)) == 0);
+
+        // Colors of 1 and 2 bytes
+        for (int bytes_per_pixel : {1, 2})
+        {
+            uint8_t mapped[LCD::BUFFER_WIDTH * 2];
+            PaletteMapper::Map(kernel, mapper.colors, bytes_per_pixel, pixels, mapped, LCD::BUFFER_WIDTH);
+            for (int i = 0; i < LCD::BUFFER_WIDTH * bytes_per_pixel; i++)
+            {
+                REQUIRE(mapped[i] == reinterpret_cast<uint8_t *>(expected)[i / bytes_per_pixel * 4 + i % bytes_per_pixel]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Framebuffer stores lines in the pixel format asked for")
+{
+    Framebuffer framebuffer;
+    REQUIRE(framebuffer.Format() == PixelFormat::RGBA8888);
+    REQUIRE(Framebuffer::LineBytes(PixelFormat::RGBA8888) == Framebuffer::Width * 4);
+
+    // BG colors 0-3 repeated, with BGP mapping them in order and OBP0 all to black
+    uint8_t pixels[Framebuffer::Width];
+    for (int x = 0; x < Framebuffer::Width; x++)
+    {
+        pixels[x] = x & 0b11;
+    }
+    pixels[5] = PaletteTag_OBJ0 | 2;
+    const uint8_t bg_palette = 0b11100100;
+    const uint8_t obj_palette = 0b11111111;
+
+    framebuffer.WriteLine(1, pixels, bg_palette, obj_palette, 0);
+    const auto *rgba = reinterpret_cast<const uint32_t *>(framebuffer.Data() + Framebuffer::Width * 4);
+    REQUIRE(rgba[0] == 0xffffffff);
+    REQUIRE(rgba[1] == 0xffaaaaaa);
+    REQUIRE(rgba[3] == 0xff000000);
+    REQUIRE(rgba[5] == 0xff000000);
+
+    framebuffer.SetFormat(PixelFormat::Gray8);
+    REQUIRE(Framebuffer::LineBytes(PixelFormat::Gray8) == Framebuffer::Width);
+    framebuffer.WriteLine(1, pixels, bg_palette, obj_palette, 0);
+    const uint8_t *gray = framebuffer.Data() + Framebuffer::Width;
+    REQUIRE(std::vector<uint8_t>(gray, gray + 6) == std::vector<uint8_t>{0xff, 0xaa, 0x55, 0x00, 0xff, 0x00});
+
+    framebuffer.SetFormat(PixelFormat::RGB565);
+    framebuffer.WriteLine(1, pixels, bg_palette, obj_palette, 0);
+    const auto *rgb565 = reinterpret_cast<const uint16_t *>(framebuffer.Data() + Framebuffer::Width * 2);
+    REQUIRE(rgb565[0] == 0xffff);
+    REQUIRE(rgb565[1] == 0xad55);
+    REQUIRE(rgb565[2] == 0x52aa);
+    REQUIRE(rgb565[5] == 0x0000);
+
+    // 4 pixels per byte, written to the last line
+    framebuffer.SetFormat(PixelFormat::Indexed2);
+    REQUIRE(Framebuffer::LineBytes(PixelFormat::Indexed2) == Framebuffer::Width / 4);
+    framebuffer.WriteLine(143, pixels, bg_palette, obj_palette, 0);
+    const uint8_t *indexed = framebuffer.Data() + 143 * Framebuffer::Width / 4;
+    REQUIRE(indexed[0] == 0b00011011);
+    REQUIRE(indexed[1] == 0b00111011);
+    REQUIRE(indexed[-1] == 0);
+}
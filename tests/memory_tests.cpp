@@ -0,0 +1,110 @@
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+#include "../HostMemory.h"
+
+TEST_CASE("Memory map follows the boot ROM and ROM bank switching")
+{
+    // 8 banks of MBC1 ROM, each filled with its bank number
+    std::vector<uint8_t> rom(8 * 0x4000);
+    for (size_t i = 0; i < rom.size(); i++)
+    {
+        rom[i] = static_cast<uint8_t>(i / 0x4000);
+    }
+    rom[0x147] = CartridgeType::MBC1;
+
+    Cartridge cart;
+    cart.Load(rom.data(), static_cast<long>(rom.size()));
+    HostMemory mem{cart};
+
+    // The boot ROM covers the first page only
+    REQUIRE(mem.Read(0x0000) == 0x31);
+    REQUIRE(mem.Read(0x0100) == 0);
+    mem.Write(IOAddress::Boot_ROM_Disabled, 1);
+    REQUIRE(mem.Read(0x0000) == 0);
+
+    REQUIRE(mem.Read(0x4000) == 1);
+    mem.Write(0x2000, 5);
+    REQUIRE(mem.Read(0x4000) == 5);
+    REQUIRE(mem.Read(0x7fff) == 5);
+    REQUIRE(mem.Read(0x3fff) == 0);
+
+    // Bank 0 selects bank 1
+    mem.Write(0x2000, 0);
+    REQUIRE(mem.Read(0x4000) == 1);
+
+    mem.Write(0x2000, 3);
+    cart.Reset();
+    REQUIRE(mem.Read(0x4000) == 1);
+}
+
+TEST_CASE("Memory map mirrors working RAM and calls the IO register handlers")
+{
+    Cartridge cart;
+    HostMemory mem{cart};
+    std::vector<uint16_t> io_writes;
+    mem.MapIORegister(0xff42, &io_writes,
+        [](void *, uint16_t address)
+        {
+            return static_cast<uint8_t>(address & 0xff);
+        },
+        [](void *writes, uint16_t address, uint8_t)
+        {
+            static_cast<std::vector<uint16_t> *>(writes)->push_back(address);
+        });
+
+    mem.Write(0xc123, 0x42);
+    REQUIRE(mem.Read(0xe123) == 0x42);
+
+    // Registers without handlers and HRAM are stored in memory
+    mem.Write(0xff80, 1);
+    mem.Write(0xff47, 2);
+    REQUIRE(mem.Read(0xff80) == 1);
+    REQUIRE(mem.Read(0xff47) == 2);
+
+    mem.Write(0xff42, 3);
+    REQUIRE(mem.Read(0xff42) == 0x42);
+    REQUIRE(io_writes == std::vector<uint16_t>{0xff42});
+
+    mem.MarkCodePage(0xc1);
+    uint32_t generation = mem.code_generation;
+    mem.Write(0xc100, 0);
+    REQUIRE(mem.code_generation == generation + 1);
+    REQUIRE(mem.modified_code_pages[0xc1]);
+
+    // Only the first write after marking the page is reported
+    mem.Write(0xc101, 0);
+    REQUIRE(mem.code_generation == generation + 1);
+}
+
+TEST_CASE("ROM banks wrap around at the size of the ROM, and only switching banks drops decoded code")
+{
+    // 4 banks of MBC1 ROM, each filled with its bank number
+    std::vector<uint8_t> rom(4 * 0x4000);
+    for (size_t i = 0; i < rom.size(); i++)
+    {
+        rom[i] = static_cast<uint8_t>(i / 0x4000);
+    }
+    rom[0x147] = CartridgeType::MBC1;
+
+    Cartridge cart;
+    cart.Load(rom.data(), static_cast<long>(rom.size()));
+    HostMemory mem{cart};
+    mem.Write(IOAddress::Boot_ROM_Disabled, 1);
+
+    // Bank 6 is bank 2 mirrored
+    mem.Write(0x2000, 6);
+    REQUIRE(cart.GetROMBank() == 2);
+    REQUIRE(mem.Read(0x4000) == 2);
+    REQUIRE(mem.Read(0x7fff) == 2);
+
+    // Selecting the bank already mapped, directly or through a mirror, keeps the decoded code
+    uint32_t generation = mem.code_generation;
+    mem.Write(0x2000, 2);
+    mem.Write(0x2100, 0x1e);
+    REQUIRE(mem.code_generation == generation);
+
+    mem.Write(0x2000, 3);
+    REQUIRE(mem.Read(0x4000) == 3);
+    REQUIRE(mem.code_generation != generation);
+}
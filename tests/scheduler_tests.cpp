@@ -0,0 +1,73 @@
+#include <catch2/catch_all.hpp>
+
+#include "../Scheduler.h"
+#include "test_rom.h"
+
+TEST_CASE("Scheduler keeps the earliest deadline")
+{
+    Scheduler scheduler;
+    REQUIRE(scheduler.NextDeadline() == Scheduler::Never);
+
+    scheduler.Schedule(Scheduler::Event::LCD, 456);
+    scheduler.Schedule(Scheduler::Event::Timer, 256);
+    REQUIRE(scheduler.NextDeadline() == 256);
+
+    scheduler.Schedule(Scheduler::Event::Timer, 512);
+    REQUIRE(scheduler.NextDeadline() == 456);
+    REQUIRE(scheduler.Deadline(Scheduler::Event::Timer) == 512);
+
+    scheduler.Schedule(Scheduler::Event::DMA, 100);
+    scheduler.Cancel(Scheduler::Event::DMA);
+    REQUIRE(scheduler.NextDeadline() == 456);
+
+    scheduler.Reset();
+    REQUIRE(scheduler.now == 0);
+    REQUIRE(scheduler.NextDeadline() == Scheduler::Never);
+}
+
+TEST_CASE("Scheduler clock follows the cycles stepped")
+{
+    auto gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+
+    uint64_t cycles = RunTestRomCycles(*gb, 1000000);
+    REQUIRE(gb->scheduler.now == cycles);
+    // Components are stepped at their deadlines, which are never left behind
+    REQUIRE(gb->scheduler.NextDeadline() > gb->scheduler.now);
+}
+
+TEST_CASE("RunFrame returns at every VBlank and RunCycles after the cycles asked for")
+{
+    auto gb = MakeGameboyWithTestRom("cpu_instrs.gb");
+
+    // The boot ROM returns to the cartridge at 0x100
+    gb->breakpoint = 0x100;
+    gb->RunCycles(400 * Gameboy::CyclesPerFrame);
+    REQUIRE(gb->cpu.regs.PC == 0x100);
+    gb->breakpoint.reset();
+
+    // The test ROM turns the LCD off while it sets up the screen, and no frame is drawn
+    uint64_t frames = gb->lcd.frame_count;
+    REQUIRE(gb->RunFrame() >= Gameboy::CyclesPerFrame);
+    REQUIRE(!gb->lcd.IsEnabled());
+    REQUIRE(gb->lcd.frame_count == frames);
+    while (!gb->lcd.IsEnabled())
+    {
+        gb->RunFrame();
+    }
+    gb->RunFrame();
+
+    // The longest instruction is 24 cycles, which can overrun the end of a frame
+    for (int i = 0; i < 10; i++)
+    {
+        uint64_t frame = gb->lcd.frame_count;
+        uint64_t cycles = gb->RunFrame();
+        REQUIRE(gb->lcd.frame_count == frame + 1);
+        REQUIRE(gb->lcd.current_scanline == 144);
+        REQUIRE(cycles > Gameboy::CyclesPerFrame - 24);
+        REQUIRE(cycles < Gameboy::CyclesPerFrame + 24);
+    }
+
+    uint64_t cycles = gb->RunCycles(100000);
+    REQUIRE(cycles >= 100000);
+    REQUIRE(cycles < 100000 + 24);
+}
@@ -0,0 +1,104 @@
+//
+// Helpers for tests that run one of the ROMs in tests/test_roms
+//
+
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include "../Gameboy.h"
+
+#ifndef TEST_ROMS_PATH
+#define TEST_ROMS_PATH "../tests/test_roms/"
+#endif
+
+/// Read a ROM from the test_roms folder. Returns an empty vector if the file could not be read.
+inline std::vector<uint8_t> ReadTestRom(const std::string &filename)
+{
+    std::filesystem::path path = std::filesystem::path(TEST_ROMS_PATH) / filename;
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        return {};
+    }
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+/// Create a Gameboy with the given test ROM inserted and the CPU reset.
+inline std::unique_ptr<Gameboy> MakeGameboyWithTestRom(const std::string &filename)
+{
+    auto rom = ReadTestRom(filename);
+    auto gb = std::make_unique<Gameboy>();
+    gb->cartridge.Load(rom.data(), static_cast<long>(rom.size()));
+    gb->cpu.reset();
+    return gb;
+}
+
+/// Step the Gameboy until at least `cycles` cycles have passed.
+/// \return the number of cycles actually spent
+inline uint64_t RunTestRomCycles(Gameboy &gb, uint64_t cycles)
+{
+    uint64_t spent = 0;
+    while (spent < cycles)
+    {
+        spent += gb.Step();
+    }
+    return spent;
+}
+
+/// The cpu_instrs tests as separate ROMs, each reporting "Passed" or "Failed" over the serial port when done
+inline const char *const CpuInstrsTestRoms[] = {
+    "01-special.gb", "02-interrupts.gb", "03-op sp,hl.gb", "04-op r,imm.gb", "05-op rp.gb", "06-ld r,r.gb",
+    "07-jr,jp,call,ret,rst.gb", "08-misc instrs.gb", "09-op r,r.gb", "10-bit ops.gb", "11-op a,(hl).gb",
+};
+
+/// Run a test ROM until it writes "Passed" or "Failed" to the serial port, or `max_cycles` have passed.
+/// \return everything the ROM wrote to the serial port
+inline std::string RunTestRomToVerdict(Gameboy &gb, uint64_t max_cycles)
+{
+    struct SerialPort
+    {
+        HostMemory &mem;
+        std::string output;
+    } serial{gb.mem, {}};
+
+    gb.mem.MapIORegister(0xff02, &serial, nullptr, [](void *component, uint16_t address, uint8_t value)
+    {
+        auto &serial = *static_cast<SerialPort *>(component);
+        if (value == 0x81)
+        {
+            serial.output += static_cast<char>(serial.mem[0xff01]);
+            value = 0x0;
+        }
+        serial.mem[address] = value;
+    });
+
+    uint64_t spent = 0;
+    while (spent < max_cycles && serial.output.find("Passed") == std::string::npos && serial.output.find("Failed") == std::string::npos)
+    {
+        spent += RunTestRomCycles(gb, 1000000);
+    }
+
+    // `serial` goes out of scope, so stop writing to it
+    gb.mem.MapIORegister(0xff02, nullptr, nullptr, nullptr);
+    return serial.output;
+}
+
+/// Require the CPU registers of two Gameboys to be the same, with their flags materialized first
+inline void RequireSameRegisters(Gameboy &a, Gameboy &b)
+{
+    a.cpu.materialize_flags();
+    b.cpu.materialize_flags();
+    REQUIRE(a.cpu.regs.AF == b.cpu.regs.AF);
+    REQUIRE(a.cpu.regs.BC == b.cpu.regs.BC);
+    REQUIRE(a.cpu.regs.DE == b.cpu.regs.DE);
+    REQUIRE(a.cpu.regs.HL == b.cpu.regs.HL);
+    REQUIRE(a.cpu.regs.SP == b.cpu.regs.SP);
+    REQUIRE(a.cpu.regs.PC == b.cpu.regs.PC);
+}
@@ -13,7 +13,7 @@ TEST_CASE("timer")
     Cartridge cart;
     HostMemory mem{cart};
     CPU cpu(mem);
-    Timer timer(mem);
+    Timer timer;
     bool didOverflow = false;
     constexpr uint8_t TimerEnabled = 0b100;
     constexpr uint8_t TimerDisabled = 0b000;
@@ -43,3 +43,172 @@ TEST_CASE("timer")
     REQUIRE(timer.GetCounter() == 0x11);
     REQUIRE(didOverflow);
 }
+
+/// The timer as it was stepped before `Timer::Step` computed whole steps at once: one cycle at a time,
+/// increasing TIMA on every falling edge of the divider bit selected in TAC, writes to DIV included
+struct ReferenceTimer
+{
+    uint16_t divider = 0;
+    uint8_t control = 0;
+    uint8_t counter = 0;
+    uint8_t modulo = 0;
+    int overflows = 0;
+
+    void DividerWasUpdated(uint16_t previous_divider_value, uint16_t new_divider_value)
+    {
+        // CPU Clock / 1024, 16, 64 and 256
+        static constexpr uint16_t bits[] = {512, 8, 32, 128};
+        uint16_t bit = bits[control & 0b11];
+        if ((control & 0b100) && (previous_divider_value & bit) && !(new_divider_value & bit))
+        {
+            if (counter == 0xff)
+            {
+                counter = modulo;
+                overflows++;
+            }
+            else
+            {
+                counter++;
+            }
+        }
+    }
+
+    void Step()
+    {
+        uint16_t previous_divider_value = divider;
+        divider++;
+        DividerWasUpdated(previous_divider_value, divider);
+    }
+
+    void SetDividerRegister()
+    {
+        uint16_t previous_divider_value = divider;
+        divider = 0;
+        DividerWasUpdated(previous_divider_value, divider);
+    }
+};
+
+TEST_CASE("Stepping the timer many cycles at once matches stepping one cycle at a time")
+{
+    ReferenceTimer reference;
+    Timer timer;
+    int overflows = 0;
+    timer.didOverflow = [&overflows]() { overflows++; };
+
+    auto require_same_state = [&]()
+    {
+        REQUIRE(timer.GetDividerRegister() == reference.divider >> 8);
+        REQUIRE(timer.GetCounter() == reference.counter);
+        REQUIRE(overflows == reference.overflows);
+    };
+    auto step = [&](uint32_t cycles)
+    {
+        for (uint32_t i = 0; i < cycles; i++)
+        {
+            reference.Step();
+        }
+        timer.Step(cycles);
+    };
+
+    for (uint8_t control = 0b100; control <= 0b111; control++)
+    {
+        for (uint8_t modulo : {0x00, 0xfe, 0xff})
+        {
+            timer.Reset();
+            timer.SetTimerControl(control);
+            timer.SetModulo(modulo);
+            timer.SetCounter(0xf0);
+            reference = {.control = control, .counter = 0xf0, .modulo = modulo, .overflows = reference.overflows};
+
+            // Uneven chunks, so they start and end all over the divider period, and wrap the 16 bit divider
+            for (uint16_t chunk : {1, 7, 300, 1023, 5000, 0xffff, 3})
+            {
+                step(chunk);
+                require_same_state();
+            }
+        }
+    }
+
+    // Steps of any length with TAC, DIV, TIMA and TMA written in between
+    uint32_t seed = 1;
+    auto random = [&seed](uint32_t range)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % range;
+    };
+    for (int i = 0; i < 20000; i++)
+    {
+        switch (random(8))
+        {
+        case 0:
+        {
+            auto control = static_cast<uint8_t>(random(8));
+            timer.SetTimerControl(control);
+            reference.control = control;
+            break;
+        }
+        case 1:
+            timer.SetDividerRegister();
+            reference.SetDividerRegister();
+            break;
+        case 2:
+        {
+            // Mostly close to overflowing
+            auto counter = static_cast<uint8_t>(0xff - random(8));
+            timer.SetCounter(counter);
+            reference.counter = counter;
+            break;
+        }
+        case 3:
+        {
+            auto modulo = static_cast<uint8_t>(0xff - random(4));
+            timer.SetModulo(modulo);
+            reference.modulo = modulo;
+            break;
+        }
+        default:
+            step(random(2) ? random(32) : random(4096));
+            break;
+        }
+        require_same_state();
+    }
+    REQUIRE(reference.overflows > 1000);
+}
+
+TEST_CASE("Writing DIV restarts the TIMA period, and increases TIMA if the selected divider bit was set")
+{
+    Timer timer;
+    int overflows = 0;
+    timer.didOverflow = [&overflows]() { overflows++; };
+
+    for (uint8_t control = 0b100; control <= 0b111; control++)
+    {
+        static constexpr uint16_t periods[] = {1024, 16, 64, 256};
+        uint16_t period = periods[control & 0b11];
+        timer.Reset();
+        timer.SetTimerControl(control);
+
+        // Half way through a period the selected bit is set, so clearing the divider is a falling edge
+        timer.Step(period / 2);
+        REQUIRE(timer.GetCounter() == 0);
+        timer.SetDividerRegister();
+        REQUIRE(timer.GetCounter() == 1);
+
+        // A full period after the write, not after the last increment
+        timer.Step(period / 2 - 1);
+        timer.SetDividerRegister();
+        REQUIRE(timer.GetCounter() == 1);
+        timer.Step(period - 1);
+        REQUIRE(timer.GetCounter() == 1);
+        timer.Step(1);
+        REQUIRE(timer.GetCounter() == 2);
+
+        // Overflowing reloads TMA and requests the interrupt on the same increment
+        timer.SetModulo(0x80);
+        timer.SetCounter(0xff);
+        int previous_overflows = overflows;
+        timer.Step(period);
+        REQUIRE(timer.GetCounter() == 0x80);
+        REQUIRE(overflows == previous_overflows + 1);
+    }
+}